@@ -0,0 +1,94 @@
+#include <QtConcurrent>
+#include <memory>
+
+#include "ExportQueue.hpp"
+
+namespace
+{
+    /**
+     * @brief Copy of the arrays of a mesh written by an exporter, the others being left empty.
+     */
+    struct MeshArrays
+    {
+        std::vector<QVector3D> positions, normals;
+        std::vector<float> elevations, plateIds;
+        std::shared_ptr<const std::vector<unsigned int>> indices;
+
+        MeshView view () const
+        {
+            MeshView view;
+            view.positions = positions;
+            view.normals = normals;
+            view.elevations = elevations;
+            view.plateIds = plateIds;
+            view.indices = *indices;
+            return view;
+        }
+    };
+}
+
+ExportQueue::ExportQueue (QObject *parent) : QObject (parent)
+{
+    // The exports are written one at a time, in the order they were queued: each of them formats in parallel.
+    pool.setMaxThreadCount(1);
+}
+
+ExportQueue::~ExportQueue ()
+{
+    pool.waitForDone();
+}
+
+void ExportQueue::enqueue (Format format, const Mesh &mesh, const QString &filename)
+{
+    // Comparing the indices reads them without allocating a copy of them for every export.
+    std::shared_ptr<const std::vector<unsigned int>> indices = sharedIndices.lock();
+    if(!indices || *indices != mesh.indices)
+    {
+        indices = std::make_shared<const std::vector<unsigned int>>(mesh.indices);
+        sharedIndices = indices;
+    }
+
+    std::shared_ptr<MeshArrays> arrays = std::make_shared<MeshArrays>();
+    arrays->positions = mesh.positions;
+    arrays->indices = indices;
+    if(format != OFF)
+        arrays->normals = mesh.normals;
+    if(format == PLY || format == GLB)
+    {
+        arrays->elevations = mesh.elevations;
+        arrays->plateIds = mesh.plateIds;
+    }
+    ++queued;
+    emit progress(filename, 0, queued);
+
+    QtConcurrent::run(&pool, [this, format, arrays, filename]{
+        int percent = 0;
+        ExportProgress report = [&](double fraction){
+            if(int(100 * fraction) > percent)
+            {
+                percent = 100 * fraction;
+                emit progress(filename, percent, queued);
+            }
+        };
+
+        const std::string file = filename.toStdString();
+        bool success = false;
+        switch(format)
+        {
+        case OBJ:
+            success = exportOBJ(arrays->view(), file, report);
+            break;
+        case OFF:
+            success = exportOFF(arrays->view(), file, report);
+            break;
+        case PLY:
+            success = exportPLY(arrays->view(), file, EXPORT_ALL_ATTRIBUTES, report);
+            break;
+        case GLB:
+            success = exportGLB(arrays->view(), file, EXPORT_ALL_ATTRIBUTES, report);
+            break;
+        }
+        --queued;
+        emit finished(filename, success);
+    });
+}
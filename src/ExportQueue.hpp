@@ -0,0 +1,75 @@
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "MeshExport.hpp"
+
+/**
+ * @brief Queue of the exports of a mesh, written one after the other in the background.
+ * Each export copies the arrays of the mesh that its format writes when it is queued, so that the mesh
+ * can change while it waits or runs. The indices, which only change with the topology of the planet,
+ * are shared by the exports queued since they last changed.
+ * The progress is reported with signals, from the thread of the export.
+ */
+class ExportQueue : public QObject {
+Q_OBJECT
+
+public:
+    enum Format {OBJ, OFF, PLY, GLB};
+
+    ExportQueue (QObject *parent = nullptr);
+
+    /**
+     * @brief Waits for the queued exports before destroying the queue.
+     * 
+     */
+    ~ExportQueue ();
+
+    /**
+     * @brief Queues the export of a copy of the mesh.
+     * 
+     * @param format 
+     * @param mesh 
+     * @param filename 
+     */
+    void enqueue (Format format, const Mesh &mesh, const QString &filename);
+
+    /**
+     * @brief Returns the number of exports queued or running.
+     * 
+     * @return int 
+     */
+    int pending () const { return queued; }
+
+signals:
+
+    /**
+     * @brief Signal sent when the export of a file progressed by at least one percent.
+     * 
+     * @param filename 
+     * @param percent 
+     * @param pending the number of exports queued or running, this one included.
+     */
+    void progress (const QString &filename, int percent, int pending);
+
+    /**
+     * @brief Signal sent once a file has been written.
+     * 
+     * @param filename 
+     * @param success false if the file could not be written.
+     */
+    void finished (const QString &filename, bool success);
+
+private:
+    QThreadPool pool;
+    std::atomic<int> queued = 0;
+    std::weak_ptr<const std::vector<unsigned int>> sharedIndices; // copy of the indices held by the pending exports
+};
+
+#endif // EXPORTQUEUE_H
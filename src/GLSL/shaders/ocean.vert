@@ -4,6 +4,7 @@ layout (location=1) in vec3 i_normals;
 
 uniform mat4 mv_matrix;
 uniform mat4 proj_matrix;
+uniform float radius_offset; // from the radius of the positions to the one of the planet
 
 out vec3 position;
 out vec3 normal;
@@ -12,7 +13,7 @@ out vec3 color;
 
 void main(void)
 {
-    position = i_position.xyz;
+    position = i_position.xyz + radius_offset * i_normals.xyz;
     normal = vec3(mat3(proj_matrix * mv_matrix) * i_normals.xyz);
     color = vec3(0,0,1);
     gl_Position = proj_matrix * mv_matrix * vec4(position, 1.0);
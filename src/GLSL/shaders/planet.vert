@@ -7,6 +7,7 @@ layout (location=4) in float i_plate_id;
 
 uniform mat4 mv_matrix;
 uniform mat4 proj_matrix;
+uniform float radius_offset; // from the radius of the positions to the one of the planet
 
 out vec3 position;
 out vec3 normal;
@@ -16,7 +17,7 @@ out smooth float plate_id;
 
 void main(void)
 {
-    position = i_position.xyz;
+    position = i_position.xyz + radius_offset * i_normals.xyz;
     normal = vec3(mat3(proj_matrix * mv_matrix) * i_normals.xyz);
     texCoord=i_texCoord;
     elevation = i_elevation;
@@ -1,9 +1,107 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <filesystem>
+#include <cstring>
+#include <iostream>
 #include "Window.hpp"
+#include "Planet.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Generates a planet from the command line arguments without any widget nor OpenGL context.
+ *
+ * @param argc
+ * @param argv
+ * @return int the exit code of the program.
+ */
+static int runHeadless (int argc, char *argv[])
+{
+	QCoreApplication a (argc, argv);
+	QCommandLineParser parser;
+	parser.setApplicationDescription ("Procedural tectonic planets generator");
+	parser.addHelpOption ();
+
+	QCommandLineOption headlessOption ("headless", "Generate a planet without opening the viewer.");
+	QCommandLineOption elemsOption ("elems", "Number of points of the planet.", "N", "6000");
+	QCommandLineOption platesOption ("plates", "Number of tectonic plates.", "K", "17");
+	QCommandLineOption seedOption ("seed", "Seed of the random generators.", "S");
+	QCommandLineOption radiusOption ("radius", "Radius of the planet (in km).", "R", "6370");
+	QCommandLineOption stepsOption ("steps", "Number of plate movement steps.", "T", "0");
+	QCommandLineOption outOption ("out", "Output file (.obj, .off, .ply, .glb or .bin snapshot).", "file", "planet.obj");
+	QCommandLineOption inOption ("in", "Snapshot (.bin) to resume instead of generating a planet.", "file");
+	QCommandLineOption traceOption ("trace", "Chrome trace of the run (needs a build with PLANET_TRACING).", "file");
+	parser.addOptions ({headlessOption, elemsOption, platesOption, seedOption, radiusOption,
+		stepsOption, outOption, inOption, traceOption});
+	parser.process (a);
+
+	bool elemsOk, platesOk, radiusOk, stepsOk, seedOk = true;
+	int elems = parser.value (elemsOption).toInt (&elemsOk);
+	int plates = parser.value (platesOption).toInt (&platesOk);
+	double radius = parser.value (radiusOption).toDouble (&radiusOk);
+	int steps = parser.value (stepsOption).toInt (&stepsOk);
+	quint64 seed = 0;
+	if (parser.isSet (seedOption))
+		seed = parser.value (seedOption).toULongLong (&seedOk);
+
+	if (!elemsOk || !platesOk || !radiusOk || !stepsOk || !seedOk
+		|| elems < 10 || plates < 2 || plates > elems || radius <= 0 || steps < 0)
+	{
+		std::cerr << "Invalid arguments" << std::endl;
+		parser.showHelp (1);
+	}
+
+	std::string out = parser.value (outOption).toStdString ();
+	std::string extension = std::filesystem::path (out).extension ().string ();
+	if (extension != ".obj" && extension != ".off" && extension != ".ply" && extension != ".glb" && extension != ".bin")
+	{
+		std::cerr << "Unsupported output format: " << out << std::endl;
+		return 1;
+	}
+
+	Planet planet;
+	planet.setElems (elems);
+	planet.setPlateNumber (plates);
+	planet.setRadius (radius);
+	if (parser.isSet (seedOption))
+		planet.setSeed (seed);
+
+	if (parser.isSet (inOption))
+	{
+		if (!planet.loadSnapshot (parser.value (inOption).toStdString ()))
+			return 1;
+	}
+	else
+		planet.initPlanet ();
+	for (int i = 0; i < steps; ++i)
+		planet.move ();
+
+	bool saved;
+	if (extension == ".off")
+		saved = planet.saveOFF (out);
+	else if (extension == ".ply")
+		saved = planet.savePLY (out);
+	else if (extension == ".glb")
+		saved = planet.saveGLB (out);
+	else if (extension == ".bin")
+		saved = planet.saveSnapshot (out);
+	else
+		saved = planet.save (out);
+	if (!saved)
+		return 1;
+
+	if (parser.isSet (traceOption) && !Trace::write (parser.value (traceOption).toStdString ()))
+		return 1;
+	return 0;
+}
 
 int main (int argc, char *argv[])
 {
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp (argv[i], "--headless") == 0)
+			return runHeadless (argc, argv);
+	}
+
 	QApplication a (argc, argv);
 	Window w;
 	std::filesystem::path fs;
@@ -10,15 +10,21 @@
 #include <QVector3D>
 #include <vector>
 #include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
 
+#include "StreamBuffer.hpp"
+#include "MipChain.hpp"
 
-struct Vertex {
-    QVector3D pos, normal;
-    QVector2D texCoords;
-    float elevation;
-    float plate_id;
-};
 
+/**
+ * @brief Attributes of the vertices of a mesh.
+ * Each attribute is stored in its own array and GPU buffer, its value being its location in the shaders.
+ */
+enum VertexAttribute {
+    POSITION, NORMAL, TEX_COORDS, ELEVATION, PLATE_ID, ATTRIBUTE_COUNT
+};
 
 /**
  * @brief Class reprensenting a Mesh.
@@ -27,15 +33,260 @@ struct Vertex {
 class Mesh
 {
 private:
-    QOpenGLBuffer *VBO=new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer), *EBO=new QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    QOpenGLBuffer *VBOs[ATTRIBUTE_COUNT] = {
+        new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer), new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer),
+        new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer), new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer),
+        new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer)
+    };
+    QOpenGLBuffer *EBO=new QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    const Mesh *indexSource = nullptr;
+    // Modified chunks of dirtyChunkSize vertices of each attribute, set from any thread and cleared by updateBuffers()
+    std::vector<unsigned char> dirtyChunks[ATTRIBUTE_COUNT];
+
+    // Persistently mapped buffers of the attributes changed by the simulation, when the context supports them.
+    // A region is only up to date with the chunks uploaded before its stamp.
+    StreamBuffer *streams[ATTRIBUTE_COUNT] = {};
+    std::vector<unsigned int> chunkStamps[ATTRIBUTE_COUNT]; // update at which each chunk was last modified
+    unsigned int regionStamps[ATTRIBUTE_COUNT][StreamBuffer::regionCount] = {};
+    unsigned int updateStamp = 0;
+
+    /**
+     * @brief Writes the modified chunks of an attribute in the next region of its stream and draws from it.
+     * The region was last written regionCount updates ago: every chunk modified since then is copied.
+     * 
+     * @param attribute 
+     * @param shader 
+     * @return size_t the number of bytes written.
+     */
+    size_t streamDirtyChunks(VertexAttribute attribute, QOpenGLShaderProgram *shader)
+    {
+        std::vector<unsigned char> &chunks = dirtyChunks[attribute];
+        std::vector<unsigned int> &stamps = chunkStamps[attribute];
+        bool modified = false;
+        for(size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            if(chunks[chunk])
+            {
+                stamps[chunk] = updateStamp;
+                chunks[chunk] = 0;
+                modified = true;
+            }
+        }
+        if(!modified)
+            return 0;
+
+        size_t bytes;
+        int components;
+        const char *data = static_cast<const char *>(attributeData(attribute, bytes, components));
+        const size_t chunkBytes = dirtyChunkSize * components * sizeof(float);
+        StreamBuffer *stream = streams[attribute];
+        char *region = stream->nextRegion();
+        const unsigned int regionStamp = regionStamps[attribute][stream->region()];
+
+        size_t written = 0;
+        for(size_t first = 0; first < stamps.size(); ++first)
+        {
+            if(stamps[first] <= regionStamp)
+                continue;
+            size_t last = first;
+            while(last + 1 < stamps.size() && stamps[last + 1] > regionStamp)
+                ++last;
+            const size_t offset = first * chunkBytes, size = std::min(bytes, (last + 1) * chunkBytes) - offset;
+            memcpy(region + offset, data + offset, size);
+            written += size;
+            first = last;
+        }
+        regionStamps[attribute][stream->region()] = updateStamp;
+
+        VAO->bind();
+        QOpenGLContext::currentContext()->extraFunctions()->glBindBuffer(GL_ARRAY_BUFFER, stream->bufferId());
+        shader->setAttributeBuffer(attribute, GL_FLOAT, stream->regionOffset(), components, 0);
+        VAO->release();
+        return written;
+    }
+
+    /**
+     * @brief Uploads the modified chunks of an attribute, each run of consecutive chunks in one write.
+     * 
+     * @param attribute 
+     * @return size_t the number of bytes uploaded.
+     */
+    size_t uploadDirtyChunks(VertexAttribute attribute)
+    {
+        std::vector<unsigned char> &chunks = dirtyChunks[attribute];
+        size_t bytes;
+        int components;
+        const char *data = static_cast<const char *>(attributeData(attribute, bytes, components));
+        if(bytes == 0 || std::find(chunks.begin(), chunks.end(), 1) == chunks.end())
+            return 0;
+
+        const size_t chunkBytes = dirtyChunkSize * components * sizeof(float);
+        size_t uploaded = 0;
+        VBOs[attribute]->bind();
+        for(size_t first = 0; first < chunks.size(); ++first)
+        {
+            if(!chunks[first])
+                continue;
+            // Small gaps are uploaded along with the chunks around them, which costs less than another write.
+            size_t last = first;
+            for(size_t next = first + 1; next < chunks.size() && next <= last + 1 + dirtyGapChunks; ++next)
+            {
+                if(chunks[next])
+                    last = next;
+            }
+            const size_t offset = first * chunkBytes, size = std::min(bytes, (last + 1) * chunkBytes) - offset;
+            VBOs[attribute]->write(offset, data + offset, size);
+            uploaded += size;
+            first = last;
+        }
+        VBOs[attribute]->release();
+        std::fill(chunks.begin(), chunks.end(), 0);
+        return uploaded;
+    }
+
+    /**
+     * @brief Returns the data of an attribute array.
+     * 
+     * @param attribute 
+     * @param o_bytes the size of the array in bytes.
+     * @param o_components the number of floats per vertex.
+     * @return const void* 
+     */
+    const void *attributeData(VertexAttribute attribute, size_t &o_bytes, int &o_components) const
+    {
+        switch(attribute)
+        {
+        case POSITION:
+            o_bytes = sizeof(QVector3D) * positions.size(); o_components = 3;
+            return positions.data();
+        case NORMAL:
+            o_bytes = sizeof(QVector3D) * normals.size(); o_components = 3;
+            return normals.data();
+        case TEX_COORDS:
+            o_bytes = sizeof(QVector2D) * texCoords.size(); o_components = 2;
+            return texCoords.data();
+        case ELEVATION:
+            o_bytes = sizeof(float) * elevations.size(); o_components = 1;
+            return elevations.data();
+        default:
+            o_bytes = sizeof(float) * plateIds.size(); o_components = 1;
+            return plateIds.data();
+        }
+    }
 
 public:
+    static constexpr size_t dirtyChunkSize = 16; // number of vertices tracked by each dirty flag
+    static constexpr size_t dirtyGapChunks = 2;  // largest run of clean chunks uploaded to merge two writes
     QOpenGLVertexArrayObject *VAO=new QOpenGLVertexArrayObject();
-    std::vector<Vertex> vertices;
+    // Vertex attributes, one array each. An attribute the mesh does not use is left empty.
+    std::vector<QVector3D> positions, normals;
+    std::vector<QVector2D> texCoords;
+    std::vector<float> elevations, plateIds;
     std::vector<unsigned int> textures;
+    std::vector<std::pair<unsigned int, QFuture<MipChain>>> pendingTextures; // textures still showing their placeholder
     std::vector<unsigned int> indices;
     Mesh(){}
 
+    /**
+     * @brief Returns the number of vertices.
+     * 
+     * @return size_t 
+     */
+    size_t vertexCount() const
+    {
+        return positions.size();
+    }
+
+    /**
+     * @brief Resizes every vertex attribute array.
+     * 
+     * @param count the number of vertices.
+     */
+    void resize(size_t count)
+    {
+        positions.resize(count);
+        normals.resize(count);
+        texCoords.resize(count);
+        elevations.resize(count);
+        plateIds.resize(count);
+    }
+
+    /**
+     * @brief Clears the vertex attribute arrays, but not the GPU buffers.
+     * 
+     */
+    void clearVertices()
+    {
+        positions.clear();
+        normals.clear();
+        texCoords.clear();
+        elevations.clear();
+        plateIds.clear();
+    }
+
+    /**
+     * @brief Marks an attribute as modified, so that the next updateBuffers() uploads it.
+     * 
+     * @param attribute 
+     */
+    void markDirty(VertexAttribute attribute)
+    {
+        std::fill(dirtyChunks[attribute].begin(), dirtyChunks[attribute].end(), 1);
+    }
+
+    /**
+     * @brief Marks the vertices [first, last) of an attribute as modified, so that the next updateBuffers() uploads them.
+     * Can be called from several threads at once.
+     * 
+     * @param attribute 
+     * @param first the first modified vertex.
+     * @param last one past the last modified vertex.
+     */
+    void markDirty(VertexAttribute attribute, size_t first, size_t last)
+    {
+        std::vector<unsigned char> &chunks = dirtyChunks[attribute];
+        last = std::min(last, chunks.size() * dirtyChunkSize);
+        for(size_t chunk = first / dirtyChunkSize; chunk * dirtyChunkSize < last; ++chunk)
+            std::atomic_ref<unsigned char>(chunks[chunk]).store(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Makes the mesh use the indices of another mesh.
+     * Both meshes then share the same index vector and index buffer. The source must have the same
+     * number of vertices and be set up before this mesh.
+     *
+     * @param source 
+     */
+    void shareIndices(const Mesh *source)
+    {
+        indexSource = source;
+        indices.clear();
+        indices.shrink_to_fit();
+    }
+
+    /**
+     * @brief Returns the indices used to draw the mesh.
+     * 
+     * @return const std::vector<unsigned int>& 
+     */
+    const std::vector<unsigned int> &drawIndices() const
+    {
+        return indexSource ? indexSource->indices : indices;
+    }
+
+    /**
+     * @brief Binds the index buffer of the source mesh to the VAO again.
+     * Must be called when the source mesh has been set up again.
+     */
+    void attachIndices()
+    {
+        if(!indexSource)
+            return;
+        VAO->bind();
+        indexSource->EBO->bind();
+        VAO->release();
+    }
+
 
     /**
      * @brief Draws the mesh with the shader program.
@@ -44,128 +295,92 @@ public:
      */
     void Draw(QOpenGLShaderProgram *shader)
     {
+        QOpenGLBuffer *ebo = indexSource ? indexSource->EBO : EBO;
         shader->bind();
         VAO->bind();
-        EBO->bind();
+        ebo->bind();
         if(textures.size() != 0)
         {
+            if(!pendingTextures.empty())
+                uploadTextures();
             for(size_t i = 0; i<textures.size(); i++)
             {
                 glActiveTexture(GL_TEXTURE0+textures[i]);
                 glBindTexture(GL_TEXTURE_2D, textures[i]);
             }
         }
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0);
+        glDrawElements(GL_TRIANGLES, drawIndices().size(), GL_UNSIGNED_INT, (void*)0);
+        for(StreamBuffer *stream : streams)
+        {
+            if(stream)
+                stream->fence();
+        }
         VAO->release();
-        EBO->release();
+        ebo->release();
         shader->release();
     }
 
+    /**
+     * @brief Creates the textures of the terrain types and starts decoding their images.
+     * The textures hold a grey placeholder until their mip chain is loaded, which happens on
+     * the global thread pool so that none of the images delays the first frames.
+     * 
+     * @param shader 
+     */
     void setTextures(QOpenGLShaderProgram *shader)
     {
-        shader->bind();
+        static const char *files[][2] = {
+            {"./res/snow_02_diff_2k.jpg", "snow"},
+            {"./res/rocks_ground_05_diff_2k.jpg", "rocks"},
+            {"./res/coast_sand_01_diff_2k.jpg", "sand"},
+            {"./res/coast_sand_rocks_02_diff_2k.jpg", "grass"}
+        };
+        static const unsigned char placeholder[3] = {128, 128, 128};
 
-        unsigned int textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        QImage texture = QImage("./res/snow_02_diff_2k.jpg");
-        texture = texture.convertToFormat(QImage::Format_RGB888);
-        unsigned char *data = texture.bits();
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_2D, 
-                        0, GL_RGB, texture.width(), texture.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, data
-            );
-        }
-        else
-        {
-            std::cout << "tex failed "<< std::endl;
-        }
-        
-        textures.push_back(textureID);
-        
-        shader->setUniformValue(shader->uniformLocation("snow"), textureID);
-
-        unsigned int textureID2;
-        glGenTextures(1, &textureID2);
-        glBindTexture(GL_TEXTURE_2D, textureID2);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        texture = QImage("./res/rocks_ground_05_diff_2k.jpg");
-        texture = texture.convertToFormat(QImage::Format_RGB888);
-        unsigned char *data2 = texture.bits();
-        if (data2)
-        {
-            glTexImage2D(GL_TEXTURE_2D, 
-                        0, GL_RGB, texture.width(), texture.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, data2
-            );
-        }
-        else
-        {
-            std::cout << "tex failed "<< std::endl;
-        }
-        
-        textures.push_back(textureID2);
-        
-        shader->setUniformValue(shader->uniformLocation("rocks"), textureID2);
-
-
-        unsigned int textureID3;
-        glGenTextures(1, &textureID3);
-        glBindTexture(GL_TEXTURE_2D, textureID3);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        texture = QImage("./res/coast_sand_01_diff_2k.jpg");
-        texture = texture.convertToFormat(QImage::Format_RGB888);
-        unsigned char *data3 = texture.bits();
-        if (data3)
-        {
-            glTexImage2D(GL_TEXTURE_2D, 
-                        0, GL_RGB, texture.width(), texture.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, data3
-            );
-        }
-        else
-        {
-            std::cout << "tex failed "<< std::endl;
-        }
-        textures.push_back(textureID3);
-        
-        shader->setUniformValue(shader->uniformLocation("sand"), textureID3);
-
-
-        unsigned int textureID4;
-        glGenTextures(1, &textureID4);
-        glBindTexture(GL_TEXTURE_2D, textureID4);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        texture = QImage("./res/coast_sand_rocks_02_diff_2k.jpg");
-        texture = texture.convertToFormat(QImage::Format_RGB888);
-        unsigned char *data4 = texture.bits();
-        if (data4)
+        shader->bind();
+        for(const auto &file : files)
         {
-            glTexImage2D(GL_TEXTURE_2D, 
-                        0, GL_RGB, texture.width(), texture.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, data4
-            );
+            unsigned int textureID;
+            glGenTextures(1, &textureID);
+            glBindTexture(GL_TEXTURE_2D, textureID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+
+            textures.push_back(textureID);
+            pendingTextures.push_back({textureID, loadMipChain(file[0])});
+            shader->setUniformValue(shader->uniformLocation(file[1]), textureID);
         }
-        else
+        shader->release();
+    }
+
+    /**
+     * @brief Uploads the mip chains which are loaded in place of their placeholder.
+     * 
+     */
+    void uploadTextures()
+    {
+        for(auto texture = pendingTextures.begin(); texture != pendingTextures.end();)
         {
-            std::cout << "tex failed "<< std::endl;
+            if(!texture->second.isFinished())
+            {
+                ++texture;
+                continue;
+            }
+            const MipChain image = texture->second.result();
+            if(!image.isNull())
+            {
+                glBindTexture(GL_TEXTURE_2D, texture->first);
+                image.upload(GL_TEXTURE_2D);
+            }
+            else
+            {
+                std::cout << "tex failed "<< std::endl;
+            }
+            texture = pendingTextures.erase(texture);
         }
-        
-        textures.push_back(textureID4);
-        
-        shader->setUniformValue(shader->uniformLocation("grass"), textureID4);
-        shader->release();
     }
 
     /**
@@ -174,28 +389,44 @@ public:
      */
     void clear()
     {
-        vertices.clear();
+        clearVertices();
         textures.clear();
+        pendingTextures.clear();
         indices.clear();
+        indexSource = nullptr;
+        for(std::vector<unsigned char> &chunks : dirtyChunks)
+            chunks.clear();
+        for(StreamBuffer *&stream : streams)
+        {
+            delete stream;
+            stream = nullptr;
+        }
         VAO->destroy();
-        VBO->destroy();
+        for(QOpenGLBuffer *VBO : VBOs)
+            VBO->destroy();
         EBO->destroy();
     }
 
     /**
-    * @brief Update the VBO in the shader program.
+    * @brief Update the VBOs with the vertices marked as dirty.
     * 
     * @param shader 
+    * @return size_t the number of bytes uploaded.
     */
-    void updateBuffers(QOpenGLShaderProgram *shader)
+    size_t updateBuffers(QOpenGLShaderProgram *shader)
     {
         shader->bind();
-        VBO->bind();
-        void * ptr = VBO->map(QOpenGLBuffer::WriteOnly);
-        memcpy(ptr, vertices.data(), sizeof(Vertex)*vertices.size());
-        VBO->unmap();
-        VBO->release();
+        size_t uploaded = 0;
+        ++updateStamp;
+        for(int attribute = 0; attribute < ATTRIBUTE_COUNT; ++attribute)
+        {
+            if(streams[attribute] && streams[attribute]->isCreated())
+                uploaded += streamDirtyChunks(VertexAttribute(attribute), shader);
+            else
+                uploaded += uploadDirtyChunks(VertexAttribute(attribute));
+        }
         shader->release();
+        return uploaded;
     }
 
     /**
@@ -211,40 +442,77 @@ public:
         if(VAO->isCreated())
         {
             VAO->destroy();
-            VBO->destroy();
+            for(QOpenGLBuffer *VBO : VBOs)
+                VBO->destroy();
             EBO->destroy();
         }
         VAO->create();
-        VBO->create();
-        EBO->create();
 
         VAO->bind();
 
-        EBO->bind();
-        EBO->setUsagePattern(QOpenGLBuffer::StaticDraw);
-        EBO->allocate(indices.data(),sizeof(unsigned int)*indices.size());
-
-        VBO->bind();
-        VBO->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-        VBO->allocate(vertices.data(),sizeof(Vertex)*vertices.size());
-        shader->enableAttributeArray(0);
-        shader->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
-
-        shader->enableAttributeArray(1);
-        shader->setAttributeBuffer(1, GL_FLOAT, offsetof(Vertex, normal), 3, sizeof(Vertex));
-
-        shader->enableAttributeArray(2);
-        shader->setAttributeBuffer(2, GL_FLOAT, offsetof(Vertex, texCoords), 2, sizeof(Vertex));
-        
-        shader->enableAttributeArray(3);
-        shader->setAttributeBuffer(3, GL_FLOAT, offsetof(Vertex, elevation), 1, sizeof(Vertex));
+        if(indexSource)
+        {
+            indexSource->EBO->bind();
+        }
+        else
+        {
+            EBO->create();
+            EBO->bind();
+            EBO->setUsagePattern(QOpenGLBuffer::StaticDraw);
+            EBO->allocate(indices.data(),sizeof(unsigned int)*indices.size());
+        }
 
-        shader->enableAttributeArray(4);
-        shader->setAttributeBuffer(4, GL_FLOAT, offsetof(Vertex, plate_id), 1, sizeof(Vertex));
+        // One buffer per attribute: an attribute the mesh does not use keeps the default value in the shader.
+        for(int attribute = 0; attribute < ATTRIBUTE_COUNT; ++attribute)
+        {
+            size_t bytes;
+            int components;
+            const void *data = attributeData(VertexAttribute(attribute), bytes, components);
+            if(bytes == 0)
+            {
+                shader->disableAttributeArray(attribute);
+                continue;
+            }
+            // The positions and elevations change at every step of the simulation: they are streamed if possible.
+            if(attribute == POSITION || attribute == ELEVATION)
+            {
+                if(!streams[attribute] && StreamBuffer::isSupported())
+                    streams[attribute] = new StreamBuffer();
+                if(streams[attribute] && streams[attribute]->create(data, bytes))
+                {
+                    QOpenGLContext::currentContext()->extraFunctions()->glBindBuffer(GL_ARRAY_BUFFER, streams[attribute]->bufferId());
+                    shader->enableAttributeArray(attribute);
+                    shader->setAttributeBuffer(attribute, GL_FLOAT, 0, components, 0);
+                    continue;
+                }
+                // The attribute falls back to a buffer object, which updateBuffers() must then use.
+                delete streams[attribute];
+                streams[attribute] = nullptr;
+            }
+            QOpenGLBuffer *VBO = VBOs[attribute];
+            VBO->create();
+            VBO->bind();
+            VBO->setUsagePattern(attribute == POSITION || attribute == ELEVATION ? QOpenGLBuffer::DynamicDraw : QOpenGLBuffer::StaticDraw);
+            VBO->allocate(data, bytes);
+            shader->enableAttributeArray(attribute);
+            shader->setAttributeBuffer(attribute, GL_FLOAT, 0, components, 0);
+            VBO->release();
+        }
+        QOpenGLContext *context = QOpenGLContext::currentContext();
+        if(context)
+            context->extraFunctions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        const size_t chunkCount = (vertexCount() + dirtyChunkSize - 1) / dirtyChunkSize;
+        for(int attribute = 0; attribute < ATTRIBUTE_COUNT; ++attribute)
+        {
+            dirtyChunks[attribute].assign(chunkCount, 0);
+            chunkStamps[attribute].assign(chunkCount, 0);
+            std::fill(std::begin(regionStamps[attribute]), std::end(regionStamps[attribute]), 0);
+        }
+        updateStamp = 0;
 
         VAO->release();
-        VBO->release();
-        EBO->release();
+        if(!indexSource)
+            EBO->release();
 
         std::cout<<"Done!"<<std::endl;
     }
@@ -0,0 +1,317 @@
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <thread>
+#include <bit>
+#include <cstring>
+#include <tbb/parallel_pipeline.h>
+
+#include "MeshExport.hpp"
+#include "Trace.hpp"
+
+namespace
+{
+    /**
+     * @brief Appends to a buffer the numbers of a line, formatted like a std::ostream of precision 4 would.
+     */
+    class LineFormatter
+    {
+    private:
+        std::string &buffer;
+
+        template<class... Args>
+        LineFormatter &number (Args... args)
+        {
+            char digits[64];
+            std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), args...);
+            buffer.append(digits, result.ptr);
+            return *this;
+        }
+
+    public:
+        LineFormatter(std::string &_buffer) : buffer(_buffer) {}
+
+        LineFormatter &text (const char *s) { buffer.append(s); return *this; }
+        LineFormatter &fixed (float f) { return number(f, std::chars_format::fixed, 4); }  // std::fixed
+        LineFormatter &general (float f) { return number(f, std::chars_format::general, 4); } // default float format
+        LineFormatter &integer (size_t i) { return number(i); }
+    };
+
+    /**
+     * @brief Reports the elements written out of all the elements of a file.
+     */
+    struct ElementProgress
+    {
+        const ExportProgress &callback;
+        size_t total, written = 0;
+
+        void add (size_t elements)
+        {
+            written += elements;
+            if(callback && total != 0)
+                callback(double(written) / total);
+        }
+    };
+
+    /**
+     * @brief Writes count elements, serialized by chunks in parallel and written in order.
+     * At most a few chunks per thread are in flight, so that the memory used does not depend on the size of the file.
+     *
+     * @param ostream
+     * @param count the number of elements.
+     * @param serialize serialize(buffer, begin, end) appends the elements begin to end - 1 to the buffer.
+     * @param progress updated after each chunk.
+     */
+    template<class F>
+    void writeChunks (std::ofstream &ostream, size_t count, F &&serialize, ElementProgress &progress)
+    {
+        const size_t chunkSize = 16384;
+        const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+        size_t nextChunk = 0;
+        tbb::parallel_pipeline(4 * std::max(1u, std::thread::hardware_concurrency()),
+            tbb::make_filter<void, size_t>(tbb::filter_mode::serial_in_order, [&](tbb::flow_control &control){
+                if(nextChunk == chunkCount)
+                    control.stop();
+                return nextChunk++;
+            })
+            & tbb::make_filter<size_t, std::pair<std::string, size_t>>(tbb::filter_mode::parallel, [&](size_t chunk){
+                TRACE_SPAN("serializeChunk");
+                const size_t begin = chunk * chunkSize, end = std::min(count, (chunk + 1) * chunkSize);
+                std::pair<std::string, size_t> elements("", end - begin);
+                serialize(elements.first, begin, end);
+                return elements;
+            })
+            & tbb::make_filter<std::pair<std::string, size_t>, void>(tbb::filter_mode::serial_in_order, [&](const std::pair<std::string, size_t> &elements){
+                ostream.write(elements.first.data(), elements.first.size());
+                progress.add(elements.second);
+            }));
+    }
+
+    /**
+     * @brief Writes count lines, formatted in parallel.
+     *
+     * @param lineBytes an estimate of the length of a line.
+     * @param format format(formatter, i) formats the line i, without its end.
+     */
+    template<class F>
+    void writeLines (std::ofstream &ostream, size_t count, size_t lineBytes, F &&format, ElementProgress &progress)
+    {
+        writeChunks(ostream, count, [&](std::string &buffer, size_t begin, size_t end){
+            buffer.reserve((end - begin) * lineBytes);
+            LineFormatter formatter(buffer);
+            for(size_t i = begin; i < end; ++i)
+            {
+                format(formatter, i);
+                buffer.push_back('\n');
+            }
+        }, progress);
+    }
+
+    /**
+     * @brief Writes count binary records of the same size, gathered in parallel.
+     *
+     * @param recordBytes
+     * @param gather gather(record, i) writes the record i at the given address.
+     */
+    template<class F>
+    void writeRecords (std::ofstream &ostream, size_t count, size_t recordBytes, F &&gather, ElementProgress &progress)
+    {
+        writeChunks(ostream, count, [&](std::string &buffer, size_t begin, size_t end){
+            buffer.resize((end - begin) * recordBytes);
+            for(size_t i = begin; i < end; ++i)
+                gather(buffer.data() + (i - begin) * recordBytes, i);
+        }, progress);
+    }
+
+    /**
+     * @brief Writes an array as is, in a single write.
+     */
+    template<class T>
+    void writeArray (std::ofstream &ostream, std::span<const T> array, ElementProgress &progress)
+    {
+        ostream.write(reinterpret_cast<const char *>(array.data()), array.size_bytes());
+        progress.add(array.size());
+    }
+}
+
+bool exportOBJ (const MeshView &mesh, const std::string &filename, const ExportProgress &progress)
+{
+    TRACE_SPAN("exportOBJ");
+    ElementProgress lines{progress, 2 * mesh.vertexCount() + mesh.indices.size() / 3};
+    std::ofstream ostream(filename, std::ios_base::out | std::ios_base::binary);
+    ostream << "o planet\n";
+    writeLines(ostream, mesh.vertexCount(), 40, [&](LineFormatter &line, size_t i){
+        const QVector3D &p = mesh.positions[i];
+        line.text("v ").fixed(p.x()).text(" ").fixed(p.y()).text(" ").fixed(p.z());
+    }, lines);
+    writeLines(ostream, mesh.vertexCount(), 24, [&](LineFormatter &line, size_t i){
+        const QVector3D &n = mesh.normals[i];
+        line.text("vn ").fixed(n.x()).text(" ").fixed(n.y()).text(" ").fixed(n.z());
+    }, lines);
+    writeLines(ostream, mesh.indices.size() / 3, 24, [&](LineFormatter &line, size_t t){
+        line.text("f ").integer(mesh.indices[3 * t]).text(" ").integer(mesh.indices[3 * t + 1]).text(" ").integer(mesh.indices[3 * t + 2]);
+    }, lines);
+    ostream.close();
+    return bool(ostream);
+}
+
+bool exportOFF (const MeshView &mesh, const std::string &filename, const ExportProgress &progress)
+{
+    TRACE_SPAN("exportOFF");
+    ElementProgress lines{progress, mesh.vertexCount() + mesh.indices.size() / 3};
+    std::ofstream ostream(filename, std::ios_base::out | std::ios_base::binary);
+    ostream << "OFF \n" << mesh.vertexCount() << " " << mesh.indices.size() / 3 << " 0\n";
+    writeLines(ostream, mesh.vertexCount(), 32, [&](LineFormatter &line, size_t i){
+        const QVector3D &p = mesh.positions[i];
+        line.general(p.x()).text(" ").general(p.y()).text(" ").general(p.z());
+    }, lines);
+    writeLines(ostream, mesh.indices.size() / 3, 24, [&](LineFormatter &line, size_t t){
+        line.text("3 ").integer(mesh.indices[3 * t]).text(" ").integer(mesh.indices[3 * t + 1]).text(" ").integer(mesh.indices[3 * t + 2]);
+    }, lines);
+    ostream.close();
+    return bool(ostream);
+}
+
+bool exportPLY (const MeshView &mesh, const std::string &filename, unsigned int attributes, const ExportProgress &progress)
+{
+    TRACE_SPAN("exportPLY");
+    // The file is little-endian like most PLY readers expect: the arrays are written as they are in memory.
+    if(std::endian::native != std::endian::little)
+        return false;
+
+    const size_t vertexCount = mesh.vertexCount(), triangleCount = mesh.indices.size() / 3;
+    const bool normals = (attributes & EXPORT_NORMALS) && mesh.normals.size() == vertexCount;
+    const bool elevations = (attributes & EXPORT_ELEVATIONS) && mesh.elevations.size() == vertexCount;
+    const bool plateIds = (attributes & EXPORT_PLATE_IDS) && mesh.plateIds.size() == vertexCount;
+
+    std::ofstream ostream(filename, std::ios_base::out | std::ios_base::binary);
+    ostream << "ply\n"
+        << "format binary_little_endian 1.0\n"
+        << "comment procedural planet\n"
+        << "element vertex " << vertexCount << "\n"
+        << "property float x\nproperty float y\nproperty float z\n";
+    if(normals)
+        ostream << "property float nx\nproperty float ny\nproperty float nz\n";
+    if(elevations)
+        ostream << "property float elevation\n";
+    if(plateIds)
+        ostream << "property float plate_id\n";
+    ostream << "element face " << triangleCount << "\n"
+        << "property list uchar uint vertex_indices\n"
+        << "end_header\n";
+
+    // The properties of a vertex are interleaved: the arrays are gathered in records, unless only the positions are written.
+    ElementProgress elements{progress, vertexCount + triangleCount};
+    const size_t vertexBytes = sizeof(QVector3D) * (normals ? 2 : 1) + sizeof(float) * (elevations + plateIds);
+    if(vertexBytes == sizeof(QVector3D))
+        writeArray(ostream, mesh.positions, elements);
+    else
+    {
+        writeRecords(ostream, vertexCount, vertexBytes, [&](char *record, size_t i){
+            memcpy(record, &mesh.positions[i], sizeof(QVector3D));
+            record += sizeof(QVector3D);
+            if(normals)
+            {
+                memcpy(record, &mesh.normals[i], sizeof(QVector3D));
+                record += sizeof(QVector3D);
+            }
+            if(elevations)
+            {
+                memcpy(record, &mesh.elevations[i], sizeof(float));
+                record += sizeof(float);
+            }
+            if(plateIds)
+                memcpy(record, &mesh.plateIds[i], sizeof(float));
+        }, elements);
+    }
+    writeRecords(ostream, triangleCount, 1 + 3 * sizeof(unsigned int), [&](char *record, size_t t){
+        record[0] = 3;
+        memcpy(record + 1, &mesh.indices[3 * t], 3 * sizeof(unsigned int));
+    }, elements);
+    ostream.close();
+    return bool(ostream);
+}
+
+bool exportGLB (const MeshView &mesh, const std::string &filename, unsigned int attributes, const ExportProgress &progress)
+{
+    TRACE_SPAN("exportGLB");
+    // glTF buffers are little-endian: the arrays are written as they are in memory.
+    if(std::endian::native != std::endian::little || mesh.vertexCount() == 0)
+        return false;
+
+    const size_t vertexCount = mesh.vertexCount();
+    struct Array
+    {
+        const char *attribute; // nullptr for the indices
+        const void *data;
+        size_t count, bytes;
+        const char *type;
+    };
+    std::vector<Array> arrays = {{"POSITION", mesh.positions.data(), vertexCount, mesh.positions.size_bytes(), "VEC3"}};
+    if((attributes & EXPORT_NORMALS) && mesh.normals.size() == vertexCount)
+        arrays.push_back({"NORMAL", mesh.normals.data(), vertexCount, mesh.normals.size_bytes(), "VEC3"});
+    if((attributes & EXPORT_ELEVATIONS) && mesh.elevations.size() == vertexCount)
+        arrays.push_back({"_ELEVATION", mesh.elevations.data(), vertexCount, mesh.elevations.size_bytes(), "SCALAR"});
+    if((attributes & EXPORT_PLATE_IDS) && mesh.plateIds.size() == vertexCount)
+        arrays.push_back({"_PLATE_ID", mesh.plateIds.data(), vertexCount, mesh.plateIds.size_bytes(), "SCALAR"});
+    arrays.push_back({nullptr, mesh.indices.data(), mesh.indices.size(), mesh.indices.size_bytes(), "SCALAR"});
+
+    // The accessor of the positions needs their bounds.
+    QVector3D min = mesh.positions[0], max = mesh.positions[0];
+    for(const QVector3D &p : mesh.positions)
+    {
+        min = QVector3D(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
+        max = QVector3D(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
+    }
+    auto vec3 = [](const QVector3D &v){
+        std::string json = "[";
+        for(int c = 0; c < 3; ++c)
+        {
+            char digits[32];
+            json.append(digits, std::to_chars(digits, digits + sizeof(digits), v[c]).ptr);
+            json += c < 2 ? "," : "]";
+        }
+        return json;
+    };
+
+    std::string attributesJson, bufferViews, accessors;
+    size_t offset = 0, elementCount = 0;
+    for(size_t a = 0; a < arrays.size(); ++a)
+    {
+        const Array &array = arrays[a];
+        const std::string index = std::to_string(a);
+        if(array.attribute)
+            attributesJson += std::string(attributesJson.empty() ? "" : ",") + "\"" + array.attribute + "\":" + index;
+        bufferViews += std::string(a ? "," : "") + "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset)
+            + ",\"byteLength\":" + std::to_string(array.bytes) + ",\"target\":" + (array.attribute ? "34962" : "34963") + "}";
+        accessors += std::string(a ? "," : "") + "{\"bufferView\":" + index + ",\"componentType\":" + (array.attribute ? "5126" : "5125")
+            + ",\"count\":" + std::to_string(array.count) + ",\"type\":\"" + array.type + "\""
+            + (a == 0 ? ",\"min\":" + vec3(min) + ",\"max\":" + vec3(max) : "") + "}";
+        offset += array.bytes; // every array is made of 4-byte values: the next one stays aligned
+        elementCount += array.count;
+    }
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"ProceduralPlanet\"},"
+        "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{" + attributesJson + "},\"indices\":" + std::to_string(arrays.size() - 1) + ",\"mode\":4}]}],"
+        "\"buffers\":[{\"byteLength\":" + std::to_string(offset) + "}],"
+        "\"bufferViews\":[" + bufferViews + "],\"accessors\":[" + accessors + "]}";
+    json.resize((json.size() + 3) & ~size_t(3), ' ');
+
+    const quint32 header[5] = {
+        0x46546C67, 2, quint32(12 + 8 + json.size() + 8 + offset), // "glTF", version, file length
+        quint32(json.size()), 0x4E4F534A                            // JSON chunk
+    };
+    const quint32 binHeader[2] = {quint32(offset), 0x004E4942};     // BIN chunk
+    std::ofstream ostream(filename, std::ios_base::out | std::ios_base::binary);
+    ostream.write(reinterpret_cast<const char *>(header), sizeof(header));
+    ostream.write(json.data(), json.size());
+    ostream.write(reinterpret_cast<const char *>(binHeader), sizeof(binHeader));
+    ElementProgress elements{progress, elementCount};
+    for(const Array &array : arrays)
+    {
+        ostream.write(static_cast<const char *>(array.data), array.bytes);
+        elements.add(array.count);
+    }
+    ostream.close();
+    return bool(ostream);
+}
@@ -0,0 +1,93 @@
+#ifndef MESHEXPORT_H
+#define MESHEXPORT_H
+
+#include <QVector3D>
+#include <string>
+#include <span>
+#include <functional>
+
+#include "Mesh.hpp"
+
+/**
+ * @brief The arrays of a mesh written by the exporters.
+ * 
+ */
+struct MeshView
+{
+    std::span<const QVector3D> positions, normals;
+    std::span<const float> elevations, plateIds;
+    std::span<const unsigned int> indices;
+
+    MeshView(){}
+    MeshView(const Mesh &mesh) : positions(mesh.positions), normals(mesh.normals),
+        elevations(mesh.elevations), plateIds(mesh.plateIds), indices(mesh.indices) {}
+
+    size_t vertexCount() const { return positions.size(); }
+};
+
+/**
+ * @brief Optional vertex attributes of the binary exports, which always contain the positions and the triangles.
+ */
+enum ExportAttribute {
+    EXPORT_NORMALS = 1, EXPORT_ELEVATIONS = 2, EXPORT_PLATE_IDS = 4,
+    EXPORT_ALL_ATTRIBUTES = EXPORT_NORMALS | EXPORT_ELEVATIONS | EXPORT_PLATE_IDS
+};
+
+/**
+ * @brief Receives the fraction of the file written so far, from the thread of the export.
+ */
+typedef std::function<void (double)> ExportProgress;
+
+/**
+ * @brief Writes the mesh as a Wavefront .obj file: its positions, normals and triangles.
+ * The lines are formatted in parallel, by chunks, with std::to_chars and written in order,
+ * which gives the same file as formatting them one after the other with a std::ofstream.
+ *
+ * @param mesh
+ * @param filename
+ * @param progress
+ * @return true if the file was written.
+ */
+bool exportOBJ (const MeshView &mesh, const std::string &filename, const ExportProgress &progress = {});
+
+/**
+ * @brief Writes the mesh as an .off file: its positions and triangles.
+ * The file is formatted like the one of exportOBJ().
+ *
+ * @param mesh
+ * @param filename
+ * @param progress
+ * @return true if the file was written.
+ */
+bool exportOFF (const MeshView &mesh, const std::string &filename, const ExportProgress &progress = {});
+
+/**
+ * @brief Writes the mesh as a little-endian binary .ply file.
+ * The elevations and the plate ids are written as the float properties elevation and plate_id.
+ * PLY interleaves the properties of a vertex: the records are gathered by chunks in parallel,
+ * except when only the positions are written, which are then written in a single write.
+ *
+ * @param mesh
+ * @param filename
+ * @param attributes the ExportAttribute to write, an attribute the mesh does not have being skipped.
+ * @param progress
+ * @return true if the file was written, which requires a little-endian machine.
+ */
+bool exportPLY (const MeshView &mesh, const std::string &filename, unsigned int attributes = EXPORT_ALL_ATTRIBUTES,
+    const ExportProgress &progress = {});
+
+/**
+ * @brief Writes the mesh as a binary glTF 2.0 file (.glb).
+ * Each attribute has its own buffer view, which is the array of the mesh written as is in a single write.
+ * The elevations and the plate ids are the custom attributes _ELEVATION and _PLATE_ID.
+ *
+ * @param mesh
+ * @param filename
+ * @param attributes the ExportAttribute to write, an attribute the mesh does not have being skipped.
+ * @param progress
+ * @return true if the file was written, which requires a little-endian machine.
+ */
+bool exportGLB (const MeshView &mesh, const std::string &filename, unsigned int attributes = EXPORT_ALL_ATTRIBUTES,
+    const ExportProgress &progress = {});
+
+#endif // MESHEXPORT_H
@@ -0,0 +1,175 @@
+#include "MipChain.hpp"
+
+#include <QImage>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <cstring>
+#include <iostream>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+const char *MipChain::cacheDirectory = "./cache/textures";
+
+namespace
+{
+    const char magic[4] = {'M', 'I', 'P', 'C'};
+    const quint32 version = 1;
+
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        qint64 sourceSize, sourceTime;
+        quint32 levelCount, padding;
+    };
+
+    struct LevelHeader
+    {
+        quint32 width, height;
+        quint64 offset; // from the start of the file, aligned on 16 bytes
+    };
+
+    /**
+     * @brief Reads the levels of a cache file content.
+     *
+     * @return true if the content is complete and was built from the given source.
+     */
+    bool parse (const unsigned char *data, size_t size, qint64 sourceSize, qint64 sourceTime, std::vector<MipChain::Level> &o_levels)
+    {
+        o_levels.clear();
+        Header header;
+        if(size < sizeof(Header))
+            return false;
+        memcpy(&header, data, sizeof(Header));
+        if(memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version
+            || header.sourceSize != sourceSize || header.sourceTime != sourceTime || header.levelCount == 0
+            || size < sizeof(Header) + header.levelCount * sizeof(LevelHeader))
+            return false;
+
+        for(quint32 l = 0; l < header.levelCount; ++l)
+        {
+            LevelHeader level;
+            memcpy(&level, data + sizeof(Header) + l * sizeof(LevelHeader), sizeof(LevelHeader));
+            if(level.offset + 3ull * level.width * level.height > size)
+            {
+                o_levels.clear();
+                return false;
+            }
+            o_levels.push_back({int(level.width), int(level.height), data + level.offset});
+        }
+        return true;
+    }
+}
+
+bool MipChain::map (const QString &cachePath, qint64 sourceSize, qint64 sourceTime)
+{
+    std::shared_ptr<QFile> cache = std::make_shared<QFile>(cachePath);
+    if(!cache->open(QIODevice::ReadOnly))
+        return false;
+    const unsigned char *data = cache->map(0, cache->size());
+    if(!data || !parse(data, cache->size(), sourceSize, sourceTime, chain))
+        return false;
+    file = cache;
+    return true;
+}
+
+bool MipChain::build (const QString &sourcePath, qint64 sourceSize, qint64 sourceTime, std::vector<unsigned char> &o_data)
+{
+    const QImage image = QImage(sourcePath).convertToFormat(QImage::Format_RGB888);
+    if(image.isNull())
+        return false;
+
+    // Every level halves the previous one, down to a single texel.
+    std::vector<LevelHeader> levels;
+    quint64 offset = sizeof(Header);
+    for(quint32 w = image.width(), h = image.height();; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+    {
+        levels.push_back({w, h, 0});
+        if(w == 1 && h == 1)
+            break;
+    }
+    offset += levels.size() * sizeof(LevelHeader);
+    for(LevelHeader &level : levels)
+    {
+        level.offset = (offset + 15) & ~quint64(15);
+        offset = level.offset + 3ull * level.width * level.height;
+    }
+
+    o_data.assign(offset, 0);
+    Header header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.levelCount = levels.size();
+    header.padding = 0;
+    memcpy(o_data.data(), &header, sizeof(Header));
+    memcpy(o_data.data() + sizeof(Header), levels.data(), levels.size() * sizeof(LevelHeader));
+
+    const size_t rowBytes = 3 * size_t(image.width());
+    for(int y = 0; y < image.height(); ++y)
+        memcpy(o_data.data() + levels[0].offset + y * rowBytes, image.constScanLine(y), rowBytes);
+
+    for(size_t l = 1; l < levels.size(); ++l)
+    {
+        const LevelHeader &source = levels[l - 1], &level = levels[l];
+        const unsigned char *src = o_data.data() + source.offset;
+        unsigned char *dst = o_data.data() + level.offset;
+        tbb::parallel_for(tbb::blocked_range<quint32>(0, level.height), [&](const tbb::blocked_range<quint32> &rows)
+        {
+            for(quint32 y = rows.begin(); y < rows.end(); ++y)
+            {
+                // The last texel of an odd row or column is dropped, the single texel of a 1-wide level is averaged with itself.
+                const unsigned char *row0 = src + 3ull * source.width * std::min(2 * y, source.height - 1);
+                const unsigned char *row1 = src + 3ull * source.width * std::min(2 * y + 1, source.height - 1);
+                for(quint32 x = 0; x < level.width; ++x)
+                {
+                    const quint32 x0 = 3 * std::min(2 * x, source.width - 1), x1 = 3 * std::min(2 * x + 1, source.width - 1);
+                    for(int c = 0; c < 3; ++c)
+                        dst[3ull * (y * level.width + x) + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+                }
+            }
+        });
+    }
+    return true;
+}
+
+MipChain MipChain::load (const QString &sourcePath)
+{
+    MipChain result;
+    const QFileInfo source(sourcePath);
+    if(!source.exists())
+        return result;
+    const qint64 sourceSize = source.size(), sourceTime = source.lastModified().toMSecsSinceEpoch();
+    const QString cachePath = QString(cacheDirectory) + "/" + QDir::cleanPath(sourcePath).replace('/', '_') + ".mip";
+    if(result.map(cachePath, sourceSize, sourceTime))
+        return result;
+
+    std::vector<unsigned char> data;
+    if(!build(sourcePath, sourceSize, sourceTime, data))
+        return result;
+
+    QSaveFile cache(cachePath);
+    if(QDir().mkpath(cacheDirectory) && cache.open(QIODevice::WriteOnly)
+        && cache.write(reinterpret_cast<const char *>(data.data()), data.size()) == qint64(data.size())
+        && cache.commit() && result.map(cachePath, sourceSize, sourceTime))
+        return result;
+
+    std::cerr << "Couldn't write the texture cache " << cachePath.toStdString() << std::endl;
+    result.own = std::make_shared<std::vector<unsigned char>>(std::move(data));
+    parse(result.own->data(), result.own->size(), sourceSize, sourceTime, result.chain);
+    return result;
+}
+
+void MipChain::upload (GLenum target) const
+{
+    // The levels are tightly packed: their rows are only 4-byte aligned when their width is a multiple of 4.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(size_t l = 0; l < chain.size(); ++l)
+    {
+        glTexImage2D(target, l, GL_RGB, chain[l].width, chain[l].height, 0, GL_RGB, GL_UNSIGNED_BYTE, chain[l].data);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,89 @@
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+
+#include <QOpenGLContext>
+#include <QString>
+#include <QFile>
+#include <QFuture>
+#include <QtConcurrent>
+#include <vector>
+#include <memory>
+
+/**
+ * @brief RGB image with its full chain of mipmaps, ready to be uploaded.
+ * The chain is built once from the source image and written in a cache file, which later loads
+ * map in memory instead of decoding the image again. The cache file is rebuilt when the size or
+ * the modification date of the source changes.
+ */
+class MipChain
+{
+public:
+    struct Level
+    {
+        int width, height;
+        const unsigned char *data; // tightly packed rows of RGB888 pixels
+    };
+
+private:
+    std::shared_ptr<QFile> file;                     // cache file whose mapping holds the levels
+    std::shared_ptr<std::vector<unsigned char>> own; // levels built but not cached
+    std::vector<Level> chain;
+
+    /**
+     * @brief Maps a cache file, checking that it was built from the current source.
+     *
+     * @param cachePath
+     * @param sourceSize
+     * @param sourceTime modification date of the source, in ms since epoch.
+     * @return true if the cache file is valid.
+     */
+    bool map (const QString &cachePath, qint64 sourceSize, qint64 sourceTime);
+
+    /**
+     * @brief Decodes the source image and computes its mipmaps by averaging 2x2 texels.
+     *
+     * @param sourcePath
+     * @param o_data the cache file content: its header followed by the levels.
+     * @return true if the image could be decoded.
+     */
+    static bool build (const QString &sourcePath, qint64 sourceSize, qint64 sourceTime, std::vector<unsigned char> &o_data);
+
+public:
+    /**
+     * @brief Directory of the cache files, relative to the working directory like the resources.
+     */
+    static const char *cacheDirectory;
+
+    /**
+     * @brief Loads the mip chain of an image, from its cache file if it is up to date.
+     *
+     * @param sourcePath
+     * @return MipChain a null chain if the image could not be read.
+     */
+    static MipChain load (const QString &sourcePath);
+
+    bool isNull () const { return chain.empty(); }
+    const std::vector<Level> &levels () const { return chain; }
+
+    /**
+     * @brief Uploads every level to a texture target of the bound texture.
+     *
+     * @param target GL_TEXTURE_2D or a face of a cube map.
+     */
+    void upload (GLenum target) const;
+};
+
+/**
+ * @brief Loads the mip chain of an image on the global thread pool.
+ *
+ * @param path
+ * @return QFuture<MipChain>
+ */
+inline QFuture<MipChain> loadMipChain(const QString &path)
+{
+    return QtConcurrent::run([path]{
+        return MipChain::load(path);
+    });
+}
+
+#endif // MIPCHAIN_H
@@ -28,6 +28,9 @@ public:
     float fractal(size_t octaves, float x, float y) const;
     float fractal(size_t octaves, float x, float y, float z) const;
 
+    // Fractal noise of a batch of 3D points given as separate coordinate arrays
+    void fractal(size_t octaves, const float* x, const float* y, const float* z, float* out, size_t count) const;
+
     /**
      * Constructor of to initialize a fractal noise summation
      *
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "OneRing.hpp"
+
+void OneRing::build (const std::vector<unsigned int> &i_triangles, size_t vertexCount)
+{
+    const size_t triangleCount = i_triangles.size() / 3;
+
+    // Every corner of a triangle brings its two other vertices, duplicates included.
+    std::vector<unsigned int> counts(vertexCount + 1, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, triangleCount), [&](const tbb::blocked_range<size_t> &r)
+    {
+        for(size_t t = r.begin(); t != r.end(); ++t)
+            for(size_t j = 0; j < 3; ++j)
+                std::atomic_ref<unsigned int>(counts[i_triangles[3 * t + j]]).fetch_add(2, std::memory_order_relaxed);
+    });
+
+    std::vector<unsigned int> cursor(vertexCount + 1);
+    std::exclusive_scan(counts.begin(), counts.end(), cursor.begin(), 0u);
+    std::vector<unsigned int> rawOffsets(cursor);
+    std::vector<unsigned int> raw(rawOffsets.back());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, triangleCount), [&](const tbb::blocked_range<size_t> &r)
+    {
+        for(size_t t = r.begin(); t != r.end(); ++t)
+        {
+            const unsigned int *tri = &i_triangles[3 * t];
+            for(size_t j = 0; j < 3; ++j)
+            {
+                unsigned int at = std::atomic_ref<unsigned int>(cursor[tri[j]]).fetch_add(2, std::memory_order_relaxed);
+                raw[at] = tri[(j + 1) % 3];
+                raw[at + 1] = tri[(j + 2) % 3];
+            }
+        }
+    });
+
+    // Sorting each row makes the result independent of the order the rows were filled in.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, vertexCount), [&](const tbb::blocked_range<size_t> &r)
+    {
+        for(size_t v = r.begin(); v != r.end(); ++v)
+        {
+            auto first = raw.begin() + rawOffsets[v], last = raw.begin() + rawOffsets[v + 1];
+            std::sort(first, last);
+            counts[v] = std::unique(first, last) - first;
+        }
+    });
+
+    std::shared_ptr<Rows> rows = std::make_shared<Rows>();
+    std::vector<unsigned int> &builtOffsets = rows->offsets, &builtNeighbours = rows->neighbours;
+    builtOffsets.resize(vertexCount + 1);
+    counts[vertexCount] = 0;
+    std::exclusive_scan(counts.begin(), counts.end(), builtOffsets.begin(), 0u);
+    builtNeighbours.resize(builtOffsets.back());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, vertexCount), [&](const tbb::blocked_range<size_t> &r)
+    {
+        for(size_t v = r.begin(); v != r.end(); ++v)
+            std::copy_n(raw.begin() + rawOffsets[v], counts[v], builtNeighbours.begin() + builtOffsets[v]);
+    });
+    share(builtOffsets, builtNeighbours, rows);
+}
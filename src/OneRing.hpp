@@ -0,0 +1,111 @@
+#ifndef ONERING_H
+#define ONERING_H
+
+#include <span>
+#include <vector>
+#include <memory>
+
+/**
+ * @brief Vertex adjacency of a triangle mesh, stored as a compressed sparse row.
+ * The neighbours of the vertex v are neighbours[offsets[v]] to neighbours[offsets[v + 1] - 1],
+ * sorted by index and without duplicates. The rows are never modified once built: copies of the
+ * adjacency share them, and they can be read in place from a mapped file.
+ */
+class OneRing
+{
+private:
+    struct Rows
+    {
+        std::vector<unsigned int> offsets, neighbours;
+    };
+
+    std::shared_ptr<const void> storage; // the rows built or copied, or the memory they are read from
+    std::span<const unsigned int> offsets;
+    std::span<const unsigned int> neighbours;
+
+public:
+    OneRing(){}
+
+    /**
+     * @brief Builds the adjacency of the triangles.
+     * 
+     * @param i_triangles three vertex indices per triangle.
+     * @param vertexCount the number of vertices of the mesh.
+     */
+    void build (const std::vector<unsigned int> &i_triangles, size_t vertexCount);
+
+    /**
+     * @brief Clears the adjacency.
+     * 
+     */
+    void clear ()
+    {
+        storage.reset();
+        offsets = {};
+        neighbours = {};
+    }
+
+    /**
+     * @brief Returns the neighbours of a vertex.
+     * 
+     * @param v 
+     * @return std::span<const unsigned int> 
+     */
+    std::span<const unsigned int> operator[] (unsigned int v) const
+    {
+        return std::span<const unsigned int>(neighbours.data() + offsets[v], offsets[v + 1] - offsets[v]);
+    }
+
+    /**
+     * @brief Returns the number of vertices.
+     * 
+     * @return size_t 
+     */
+    size_t size () const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    bool empty () const { return offsets.empty(); }
+
+    /**
+     * @brief Returns the offsets of the rows of the adjacency, for serialization.
+     * 
+     * @return std::span<const unsigned int> 
+     */
+    std::span<const unsigned int> rowOffsets () const { return offsets; }
+
+    /**
+     * @brief Returns the neighbours of all the vertices, for serialization.
+     * 
+     * @return std::span<const unsigned int> 
+     */
+    std::span<const unsigned int> allNeighbours () const { return neighbours; }
+
+    /**
+     * @brief Sets the adjacency from serialized rows, as returned by rowOffsets() and allNeighbours().
+     * 
+     * @param _offsets 
+     * @param _neighbours 
+     */
+    void assign (std::span<const unsigned int> _offsets, std::span<const unsigned int> _neighbours)
+    {
+        std::shared_ptr<Rows> rows = std::make_shared<Rows>();
+        rows->offsets.assign(_offsets.begin(), _offsets.end());
+        rows->neighbours.assign(_neighbours.begin(), _neighbours.end());
+        share(rows->offsets, rows->neighbours, rows);
+    }
+
+    /**
+     * @brief Sets the adjacency from serialized rows without copying them.
+     * 
+     * @param _offsets 
+     * @param _neighbours 
+     * @param _storage keeps the memory of the rows alive as long as the adjacency uses them.
+     */
+    void share (std::span<const unsigned int> _offsets, std::span<const unsigned int> _neighbours, std::shared_ptr<const void> _storage)
+    {
+        storage = std::move(_storage);
+        offsets = _offsets;
+        neighbours = _neighbours;
+    }
+};
+
+#endif // ONERING_H
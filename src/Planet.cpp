@@ -1,14 +1,23 @@
 #include <iostream>
-#include <fstream>
 #include <algorithm>
-#include <filesystem>
 #include <execution>
 #include <cassert>
 #include <vector>
+#include <numeric>
+#include <atomic>
 #include <QRandomGenerator>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/flow_graph.h>
 
 #include "Planet.hpp"
 #include "Plate.hpp"
+#include "SphereTriangulation.hpp"
+#include "ShaderProgram.hpp"
+#include "MeshExport.hpp"
+#include "Trace.hpp"
+#include "TopologyCache.hpp"
 
 #define PI 3.14159265358979323846
 
@@ -27,15 +36,19 @@ float dist(const QVector3D& p, const QVector3D &p2)
     return sqrt((delta_x*delta_x) + (delta_y*delta_y) + (delta_z*delta_z));
 }
 
-Planet::Planet (QOpenGLContext *context)
+Planet::Planet ()
 {
-    glContext = context;
-    glFunctions = glContext->extraFunctions();
     float frequency = 5.0f, amplitude = 2.0f, lacunarity = 2.0f,persistence = 0.7f;
     this->noise = SimplexNoise(frequency, amplitude, lacunarity, persistence);
     this->octaveContinent=1;
     this->octaveOcean=1;
     init ();
+}
+
+Planet::Planet (QOpenGLContext *context) : Planet ()
+{
+    glContext = context;
+    glFunctions = glContext->extraFunctions();
     initGLSL ();
 }
 
@@ -49,8 +62,6 @@ void Planet::init ()
 {
     planetCreated = false;
     needInitBuffers = true;
-    program = new QOpenGLShaderProgram();
-    oceanProgram = new QOpenGLShaderProgram();
     this->plateNum = 17;
     this->radius = 6370*1000;
     this->elems = 6000;
@@ -71,57 +82,74 @@ void Planet::initGLSL ()
     glEnable ( GL_DEBUG_OUTPUT);
     glFunctions->glDebugMessageCallback (Planet::MessageCallback, 0);
 
-    std::filesystem::path fs = std::filesystem::current_path ();
-    std::string path = fs.string () + "/GLSL/shaders/";
-    QString  vShaderPath = QString::fromStdString(path + "planet.vert");
-    QString  fShaderPath = QString::fromStdString(path + "planet.frag");
-    if(!program->addShaderFromSourceFile(QOpenGLShader::Vertex,vShaderPath)) [[unlikely]]
-    {
-        std::cerr<<program->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add VERTEX shader"<<std::endl;
-    }
-    if(!program->addShaderFromSourceFile(QOpenGLShader::Fragment,fShaderPath))[[unlikely]]
-    {
-        std::cerr<<program->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add FRAGMENT shader"<<std::endl;
-    }
-
-    if(!program->link())[[unlikely]]
-    {
-        std::cerr<<program->log().toStdString()<<std::endl;
-        std::cerr<<"Error linking program"<<std::endl;
-    }
+    program = loadShaderProgram("planet");
     programID = program->programId();
 
-    vShaderPath = QString::fromStdString(path + "ocean.vert");
-    fShaderPath = QString::fromStdString(path + "ocean.frag");
-    if(!oceanProgram->addShaderFromSourceFile(QOpenGLShader::Vertex,vShaderPath))[[unlikely]]
-    {
-        std::cerr<<oceanProgram->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add VERTEX shader"<<std::endl;
-    }
-    if(!oceanProgram->addShaderFromSourceFile(QOpenGLShader::Fragment,fShaderPath))[[unlikely]]
-    {
-        std::cerr<<oceanProgram->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add FRAGMENT shader"<<std::endl;
-    }
-
-    if(!oceanProgram->link())[[unlikely]]
-    {
-        std::cerr<<oceanProgram->log().toStdString()<<std::endl;
-        std::cerr<<"Error linking program"<<std::endl;
-    }
+    oceanProgram = loadShaderProgram("ocean");
     oceanProgramID = oceanProgram->programId();
 }
 
-void Planet::initPlanet ()
+quint64 Planet::nextSeed ()
 {
-    makeSphere ();
-    triangulate();
-    makeOcean();
-    makePlates ();
-    initElevations();
+    if(fixedSeed)
+        return seed + seedStream++;
+    return rdtsc();
+}
 
+void Planet::initPlanet ()
+{
+    TRACE_SPAN("initPlanet");
+    seedStream = 0;
+    steps = 0;
+    const bool keepTopology = hasTopology();
+    if(keepTopology)
+        std::cout<<"Reusing the triangulation of the previous planet"<<std::endl;
+    bool cachedTopology = false;
+
+    // Every stage only waits for the stages whose results it reads, so that the grid, the ocean and the
+    // triangulation followed by the plates run at the same time on the TBB workers. The plates and the
+    // elevations draw their seeds in the same order as before, which keeps the planet of a seed the same.
+    // The points of the sphere are computed again, the same as the ones of the topology kept.
+    typedef tbb::flow::continue_node<tbb::flow::continue_msg> Stage;
+    typedef const tbb::flow::continue_msg &Start;
+    tbb::flow::graph graph;
+    Stage sphereStage(graph, [this](Start){ makeSphere (); });
+    Stage gridStage(graph, [this, keepTopology](Start){
+        if(!keepTopology)
+            buildGrid ();
+    });
+    Stage oceanStage(graph, [this](Start){ makeOcean (); });
+    Stage triangulationStage(graph, [this, keepTopology, &cachedTopology](Start){
+        if(keepTopology)
+            return;
+        cachedTopology = loadTopology ();
+        if(!cachedTopology)
+            triangulate ();
+    });
+    Stage oneRingStage(graph, [this, keepTopology, &cachedTopology](Start){
+        TRACE_SPAN("buildOneRing");
+        if(!keepTopology && !cachedTopology)
+            one_ring.build(mesh.indices, mesh.vertexCount());
+    });
+    Stage cacheStage(graph, [this, keepTopology, &cachedTopology](Start){
+        TRACE_SPAN("saveTopology");
+        if(!keepTopology && !cachedTopology)
+            TopologyCache::save(mesh.vertexCount(), mesh.indices, one_ring);
+    });
+    Stage platesStage(graph, [this](Start){ makePlates (); });
+    Stage elevationsStage(graph, [this](Start){ initElevations (); });
+
+    tbb::flow::make_edge(sphereStage, gridStage);
+    tbb::flow::make_edge(sphereStage, oceanStage);
+    tbb::flow::make_edge(sphereStage, triangulationStage);
+    tbb::flow::make_edge(triangulationStage, oneRingStage);
+    tbb::flow::make_edge(oneRingStage, platesStage);
+    tbb::flow::make_edge(oneRingStage, cacheStage);
+    tbb::flow::make_edge(platesStage, elevationsStage);
+    sphereStage.try_put(tbb::flow::continue_msg());
+    graph.wait_for_all();
+
+    topologyElems = elems;
     planetCreated = true;
 }
 
@@ -135,50 +163,32 @@ QVector3D normalize(const QVector3D &v)
 
 void Planet::makeOcean ()
 {
+    TRACE_SPAN("makeOcean");
     std::cout<<"Making ocean mesh..."<<std::endl;
-    oceanMesh.vertices.resize(elems);
-    std::vector<QVector3D> pos;
-
-    double goldenRatio = (1 + pow(5,0.5))/2;
+    oceanMesh.positions.resize(elems);
+    oceanMesh.normals.resize(elems);
 
+    // The ocean is the sphere of makeSphere() before elevation: it shares the planet's triangulation.
     for (long i = 0; i < elems; ++i)
     {
-        double theta = 2 * PI * i / goldenRatio;
-        double phi = acosf(1 - 2 * (i+0.5f) / elems);
-        double x = cosf(theta)*sinf(phi), y=sinf(theta)*sinf(phi), z=cosf(phi);
-
-        QVector3D position = QVector3D (x * radius, y * radius, z * radius);
-        QVector3D normal = normalize(position);
-        pos.push_back(position);
-        oceanMesh.vertices[i].pos=position;
-        oceanMesh.vertices[i].normal=normal;
-    }
-
-    Point_set points;
-    for(const QVector3D &po: pos)
-        points.insert(Point(po.x(),po.y(),po.z()));
-
-    typedef std::array<std::size_t, 3> Facet; // Triple of indices
-    std::vector<Facet> facets;
-    
-    CGAL::advancing_front_surface_reconstruction(points.points().begin(),
-      points.points().end(),
-      std::back_inserter(facets));
-    for(size_t i = 0; i<facets.size(); ++i)
-    {
-        for(size_t j = 0; j<3; ++j)
-            oceanMesh.indices.push_back(facets[i][j]);
+        oceanMesh.positions[i] = pos[i] * radius;
+        oceanMesh.normals[i] = pos[i];
     }
+    oceanRadius = radius;
+    oceanMesh.shareIndices(&mesh);
 
     std::cout<<"Done!"<<std::endl;
 }
 
 void Planet::makeSphere ()
 {
+    TRACE_SPAN("makeSphere");
     std::cout<<"Making the points of the sphere..."<<std::endl;
     // Calc The Vertices
-    mesh.vertices.resize(elems);
-    pos.clear();
+    // The topology kept by clear() is the one of the same points, which only replace themselves in pos.
+    if(!hasTopology())
+        grid.clear();
+    mesh.resize(elems);
     pos.resize(elems);
 
     double goldenRatio = (1 + pow(5,0.5))/2;
@@ -189,93 +199,82 @@ void Planet::makeSphere ()
         double phi = acosf(1 - 2 * (i+0.5f) / elems);
         double x = cosf(theta)*sinf(phi), y=sinf(theta)*sinf(phi), z=cosf(phi);
 
+        // The normal is computed on the unit sphere, so that the topology does not depend on the radius.
         QVector3D position = QVector3D (x * radius, y * radius, z * radius) ;
-        double squareLength = position.x()*position.x() + position.y()*position.y() + position.z()*position.z(); ;
+        QVector3D unit = QVector3D (x, y, z);
+        double squareLength = unit.x()*unit.x() + unit.y()*unit.y() + unit.z()*unit.z(); ;
         double length = sqrt(squareLength);
-        QVector3D normal = QVector3D(position.x()/length,position.y()/length,position.z()/length);
+        QVector3D normal = QVector3D(unit.x()/length,unit.y()/length,unit.z()/length);
         QVector2D texCoord = QVector2D((float )i / elems, (float)i / elems);
-        pos[i]=position;
-        mesh.vertices[i].pos=position;
-        mesh.vertices[i].normal=normal;
-        mesh.vertices[i].texCoords = texCoord;
+        pos[i]=normal;
+        mesh.positions[i]=position;
+        mesh.normals[i]=normal;
+        mesh.texCoords[i] = texCoord;
     }
+    meshRadius = radius;
     std::cout<<"Done!"<<std::endl;
 }
 
 
 void Planet::triangulate()
 {
+    TRACE_SPAN("triangulate");
     std::cout<<"triangulation started..."<<std::endl;
-    Point_set points;
-    for(const QVector3D &po: pos)
-        points.insert(Point(po[0],po[1],po[2]));
 
-    typedef std::array<std::size_t, 3> Facet; // Triple of indices
-    std::vector<Facet> facets;
-    
-    start = std::chrono::system_clock::now();
+    triangulateSphere(pos, mesh.indices);
 
-    CGAL::advancing_front_surface_reconstruction(points.points().begin(),
-      points.points().end(),
-      std::back_inserter(facets));
+    std::cout << mesh.indices.size () / 3
+    << " facet(s) generated by triangulation." << std::endl;
+    std::cout<<"triangulation finished!"<<std::endl;
+}
 
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    std::cout << "elapsed time for triangulation: " << elapsed_seconds.count() << "s\n";
+bool Planet::hasTopology () const
+{
+    return topologyElems == elems && !grid.empty() && !one_ring.empty()
+        && mesh.indices.size() > 0 && pos.size() == size_t(elems);
+}
 
-    std::cout << facets.size ()
-    << " facet(s) generated by reconstruction." << std::endl;
-    for(size_t i = 0; i<facets.size(); ++i)
-    {
-        for(size_t j = 0; j<3; ++j)
-            mesh.indices.push_back(facets[i][j]);
-    }
-    std::cout<<"triangulation finished!"<<std::endl;
+bool Planet::loadTopology ()
+{
+    TRACE_SPAN("loadTopology");
+    const TopologyCache cache = TopologyCache::load(elems);
+    if(cache.isNull())
+        return false;
+    mesh.indices.assign(cache.triangles().begin(), cache.triangles().end());
+    one_ring = cache.oneRing();
+    std::cout << mesh.indices.size () / 3 << " facet(s) read from the topology cache" << std::endl;
+    return true;
 }
 
-void Planet::collect_one_ring (std::vector<QVector3D> const & i_vertices,
-    std::vector< unsigned int > const & i_triangles,
-    std::vector<std::vector<unsigned int> > & o_one_ring) {
-    o_one_ring.clear();
-    o_one_ring.resize(i_vertices.size());
-    size_t i, j, y, size=i_triangles.size();
-    for(i = 0; i<size; i+=3)
-    {
-        for(j = 0; j<3; ++j) //sommet courant
-        {
-            for(y = 0; y<3 ;++y) // sommets voisins
-            {
-                if(j!=y) [[likely]]
-                {
-                    if(std::find(std::execution::par,o_one_ring.begin(), o_one_ring.end(),
-                        o_one_ring[i_triangles[i]]) != o_one_ring.end()) [[likely]]
-                    {
-                        o_one_ring[i_triangles[i+j]].push_back(i_triangles[i+y]);
-                    }
-                }
-            }
-        }
-    }
+void Planet::buildGrid()
+{
+    TRACE_SPAN("buildGrid");
+    grid.build(pos, 2 * sqrt(4 * PI / pos.size()));
 }
 
 void Planet::makePlates ()
 {
+    TRACE_SPAN("makePlates");
     std::cout<<"Segmentation started..."<<std::endl;
-    start = std::chrono::system_clock::now();
     
-    if(one_ring.size()==0){
-        collect_one_ring(pos,mesh.indices,one_ring);
-        one_ring.shrink_to_fit();
+    if(one_ring.empty())
+    {
+        TRACE_SPAN("buildOneRing");
+        one_ring.build(mesh.indices, mesh.vertexCount());
     }
 
     plates.clear ();
     plates.resize (plateNum);
 
     QRandomGenerator prng;
-    prng.seed(rdtsc());
-    std::set<unsigned int> tmp_init;
-    std::vector<std::vector<unsigned int>> last_ids;
-    last_ids.resize(plateNum);
+    prng.seed(nextSeed());
+
+    // Owner of every vertex, as level * plateNum + plate: a plate reaching a vertex at the same level
+    // as a plate of higher index takes it, which is the result of growing the plates one after the other.
+    const unsigned int unassigned = std::numeric_limits<unsigned int>::max();
+    plateOwner.assign(mesh.vertexCount(), unassigned);
+    frontiers.resize(plateNum);
+    nextFrontiers.resize(plateNum);
 
     plates[0].type=OCEANIC;
     plates[1].type=CONTINENTAL; 
@@ -291,308 +290,326 @@ void Planet::makePlates ()
 
     for(unsigned short i = 0; i < plateNum; ++i)
     {
-        unsigned int first_point_of_plate = prng.bounded((unsigned int)mesh.vertices.size()-1);
-        while(std::find(std::execution::par,tmp_init.begin(), tmp_init.end(), first_point_of_plate) != tmp_init.end())
-        { first_point_of_plate = prng.bounded((unsigned int)mesh.vertices.size()-1); }
-        tmp_init.insert(first_point_of_plate);
+        unsigned int first_point_of_plate = prng.bounded((unsigned int)mesh.vertexCount()-1);
+        while(plateOwner[first_point_of_plate] != unassigned)
+        { first_point_of_plate = prng.bounded((unsigned int)mesh.vertexCount()-1); }
+        plateOwner[first_point_of_plate] = i;
 
-        mesh.vertices[first_point_of_plate].plate_id = i;
+        mesh.plateIds[first_point_of_plate] = i;
         plates[i].points.push_back(first_point_of_plate);
-        last_ids[i] = one_ring[first_point_of_plate];
+        frontiers[i].assign(one_ring[first_point_of_plate].begin(), one_ring[first_point_of_plate].end());
     }
 
-    std::vector<std::vector<unsigned int>> next_ids;
-    next_ids.resize(plateNum);
-
-    while(mesh.vertices.size() != tmp_init.size())
+    std::vector<unsigned int> plateIds(plateNum);
+    std::iota(plateIds.begin(), plateIds.end(), 0);
+    auto forEachPlate = [&](auto &&f){
+        if(concurrentGrowth)
+            std::for_each(std::execution::par, plateIds.begin(), plateIds.end(), f);
+        else
+            std::for_each(plateIds.begin(), plateIds.end(), f);
+    };
+
+    for(unsigned int level = 1; std::any_of(frontiers.begin(), frontiers.end(),
+        [](const std::vector<unsigned int> &f){ return !f.empty(); }); ++level)
     {
-        for(unsigned short i = 0; i<plateNum; ++i)
-        {
-            while(!last_ids[i].empty())
+        forEachPlate([&](unsigned int i){
+            TRACE_SPAN("growPlate");
+            const unsigned int key = level * plateNum + i;
+            nextFrontiers[i].clear();
+            for(auto current_vertex = frontiers[i].rbegin(); current_vertex != frontiers[i].rend(); ++current_vertex)
             {
-                unsigned int current_vertex = last_ids[i].back();
-                last_ids[i].pop_back();
-                std::vector<unsigned int> neighbours = one_ring[current_vertex];
-                for(size_t n = 0; n < neighbours.size(); ++n)
+                for(unsigned int neighbour : one_ring[*current_vertex])
                 {
-                    if(!tmp_init.contains(neighbours[n]))
+                    std::atomic_ref<unsigned int> owner(plateOwner[neighbour]);
+                    unsigned int current = owner.load(std::memory_order_relaxed);
+                    while(key < current)
                     {
-                        tmp_init.insert(neighbours[n]);
-                        plates[i].points.push_back(neighbours[n]);
-                        mesh.vertices[neighbours[n]].plate_id=i;
-                        next_ids[i].push_back(neighbours[n]);
+                        if(owner.compare_exchange_weak(current, key, std::memory_order_relaxed))
+                        {
+                            nextFrontiers[i].push_back(neighbour);
+                            break;
+                        }
                     }
                 }
             }
-            last_ids[i] = next_ids[i];
-            next_ids[i].clear();
-        }
+        });
+
+        // Only keep the vertices that no plate of lower index reached at this level.
+        forEachPlate([&](unsigned int i){
+            const unsigned int key = level * plateNum + i;
+            frontiers[i].clear();
+            for(unsigned int vertex : nextFrontiers[i])
+            {
+                if(plateOwner[vertex] == key)
+                {
+                    frontiers[i].push_back(vertex);
+                    plates[i].points.push_back(vertex);
+                    mesh.plateIds[vertex] = i;
+                }
+            }
+        });
     }
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    std::cout << "elapsed time for segmentation: " << elapsed_seconds.count() << "s"<<std::endl;
     std::cout<<"Segmentation finished!"<<std::endl;
 }
 
-void Planet::initElevations()
+/**
+ * @brief Calls f(plate, begin, end) on ranges of the points of the plates of the given type.
+ * The plates and the ranges of their points are processed in parallel.
+ */
+template<class F>
+static void forEachPlateRange (const std::vector<Plate> &plates, PlateType type, size_t grainSize, F &&f)
 {
-    std::cout<<"Initializing plate states..."<<std::endl;
-    start = std::chrono::system_clock::now();
-    QRandomGenerator prng;
-    prng.seed(rdtsc());
-    qint32 offsetX = prng.bounded(0,10000), offsetY = prng.bounded(0,10000),offsetZ = prng.bounded(0,10000);
-    for(Plate &plate: plates){
-        if(plate.type == OCEANIC) // intialize oceanic plate
+    tbb::parallel_for(size_t(0), plates.size(), [&](size_t p){
+        const Plate &plate = plates[p];
+        if(plate.type != type)
+            return;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, plate.points.size(), grainSize), [&](const tbb::blocked_range<size_t> &range){
+            f(plate, range.begin(), range.end());
+        });
+    });
+}
+
+void Planet::elevatePlates(PlateType type, const QVector3D &offset)
+{
+    const unsigned int octaves = type == OCEANIC ? octaveOcean : octaveContinent;
+    constexpr size_t batchSize = 256;
+    forEachPlateRange(plates, type, batchSize, [&](const Plate &plate, size_t begin, size_t end){
+        TRACE_SPAN("elevatePoints");
+        float x[batchSize], y[batchSize], z[batchSize], values[batchSize];
+        for(size_t first = begin; first < end; first += batchSize)
         {
-            for(const unsigned int &point : plate.points)
-            { 
-                double rng = noise.fractal(octaveOcean,mesh.vertices[point].pos.x()+offsetX,mesh.vertices[point].pos.y()+offsetY,mesh.vertices[point].pos.z()+offsetZ)+1.0;
-                double elevation = (plateParams.oceanicElevation) * rng;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal); // move the point along the normal's direction
-                mesh.vertices[point].elevation = -rng;
+            const size_t count = std::min(batchSize, end - first);
+            for(size_t k = 0; k < count; ++k)
+            {
+                const QVector3D &p = mesh.positions[plate.points[first + k]];
+                x[k] = p.x() + offset.x();
+                y[k] = p.y() + offset.y();
+                z[k] = p.z() + offset.z();
             }
+            noise.fractal(octaves, x, y, z, values, count);
 
-        } else { // intialize continental plate
-            for(const unsigned int &point : plate.points)
+            for(size_t k = 0; k < count; ++k)
             {
-                double rng = noise.fractal(octaveContinent,mesh.vertices[point].pos.x()+offsetX,mesh.vertices[point].pos.y()+offsetY,mesh.vertices[point].pos.z()+offsetZ)+0.5;
-                double elevation = (plateParams.continentalElevation)* rng;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal);
-                mesh.vertices[point].elevation = rng;
+                const unsigned int point = plate.points[first + k];
+                if(type == OCEANIC)
+                {
+                    double rng = values[k]+1.0;
+                    double elevation = (plateParams.oceanicElevation) * rng;
+                    mesh.positions[point] = mesh.positions[point] + ((elevation) * mesh.normals[point]); // move the point along the normal's direction
+                    mesh.elevations[point] = -rng;
+                } else {
+                    double rng = values[k]+0.5;
+                    double elevation = (plateParams.continentalElevation)* rng;
+                    mesh.positions[point] = mesh.positions[point] + ((elevation) * mesh.normals[point]);
+                    mesh.elevations[point] = rng;
+                }
+                mesh.markDirty(POSITION, point, point + 1);
+                mesh.markDirty(ELEVATION, point, point + 1);
             }
         }
-    }
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    std::cout << "Initialization time: " << elapsed_seconds.count() << "s\n";
-    std::cout<<"Initialization finished!"<<std::endl;
+    });
 }
 
-void Planet::resetHeights()
+void Planet::flattenPlates(PlateType type)
 {
-    for(Plate &plate: plates){ // Reinitialize height of the points
-        if(plate.type == OCEANIC)
+    forEachPlateRange(plates, type, 1024, [&](const Plate &plate, size_t begin, size_t end){
+        for(size_t k = begin; k < end; ++k)
         {
-            for(const unsigned int &point : plate.points)
-            {
-                double elevation = (plateParams.oceanicElevation) * mesh.vertices[point].elevation;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal); // move the point along the normal's direction
-                mesh.vertices[point].elevation = 0.0;
-            }
-
-        } else { 
-            for(const unsigned int &point : plate.points)
+            const unsigned int point = plate.points[k];
+            if(type == OCEANIC)
             {
-                double elevation = (plateParams.continentalElevation) * mesh.vertices[point].elevation;
-                mesh.vertices[point].pos = mesh.vertices[point].pos - ((elevation) * mesh.vertices[point].normal);
-                mesh.vertices[point].elevation = 0.0;
+                double elevation = (plateParams.oceanicElevation) * mesh.elevations[point];
+                mesh.positions[point] = mesh.positions[point] + ((elevation) * mesh.normals[point]); // move the point along the normal's direction
+            } else {
+                double elevation = (plateParams.continentalElevation) * mesh.elevations[point];
+                mesh.positions[point] = mesh.positions[point] - ((elevation) * mesh.normals[point]);
             }
+            mesh.elevations[point] = 0.0;
+            mesh.markDirty(POSITION, point, point + 1);
+            mesh.markDirty(ELEVATION, point, point + 1);
         }
-    }
+    });
+}
+
+void Planet::initElevations()
+{
+    TRACE_SPAN("initElevations");
+    std::cout<<"Initializing plate states..."<<std::endl;
+    QRandomGenerator prng;
+    prng.seed(nextSeed());
+    qint32 offsetX = prng.bounded(0,10000), offsetY = prng.bounded(0,10000),offsetZ = prng.bounded(0,10000);
+    // The oceanic and the continental plates have no point in common.
+    tbb::parallel_invoke(
+        [&]{ elevatePlates(OCEANIC, QVector3D(offsetX, offsetY, offsetZ)); },
+        [&]{ elevatePlates(CONTINENTAL, QVector3D(offsetX, offsetY, offsetZ)); });
+    std::cout<<"Initialization finished!"<<std::endl;
+}
+
+void Planet::resetHeights()
+{
+    // Reinitialize height of the points
+    flattenPlates(OCEANIC);
+    flattenPlates(CONTINENTAL);
 }
 
 void Planet::resegment()
 {
+    TRACE_SPAN("resegment");
     std::cout<<"Resegmentating..."<<std::endl;
-    start = std::chrono::system_clock::now();
 
     resetHeights();
 
     needInitBuffers = true;
     makePlates();
     initElevations();
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    std::cout << "Resegmentating time: " << elapsed_seconds.count() << "s\n";
     std::cout<<"Resegmentating finished!"<<std::endl;
 }
 
 void Planet::reelevateOcean()
 {
-    for(Plate &plate: plates){ // Reinitialize height of the points
-        if(plate.type == OCEANIC)
-        {
-            for(const unsigned int &point : plate.points)
-            {
-                double elevation = (plateParams.oceanicElevation) * mesh.vertices[point].elevation;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal); // move the point along the normal's direction
-                mesh.vertices[point].elevation = 0.0;
-            }
-
-        }
-    }
+    flattenPlates(OCEANIC);
     needBuffersUpdate=true;
 
     QRandomGenerator prng;
-    prng.seed(rdtsc());
+    prng.seed(nextSeed());
     qint32 offsetX = prng.bounded(0,10000), offsetY = prng.bounded(0,10000),offsetZ = prng.bounded(0,10000);
-    for(Plate &plate: plates){
-        if(plate.type == OCEANIC) // intialize oceanic plate
-        {
-            for(const unsigned int &point : plate.points)
-            { 
-                double rng = noise.fractal(octaveOcean,mesh.vertices[point].pos.x()+offsetX,mesh.vertices[point].pos.y()+offsetY,mesh.vertices[point].pos.z()+offsetZ)+1.0;
-                double elevation = (plateParams.oceanicElevation) * rng;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal); // move the point along the normal's direction
-                mesh.vertices[point].elevation = -rng;
-            }
-
-        } 
-    }
-
+    elevatePlates(OCEANIC, QVector3D(offsetX, offsetY, offsetZ));
 }
 
 void Planet::reelevateContinent()
 {
-    for(Plate &plate: plates){ // Reinitialize height of the points
-        if(plate.type == CONTINENTAL)
-        {
-            for(const unsigned int &point : plate.points)
-            {
-                double elevation = (plateParams.continentalElevation) * mesh.vertices[point].elevation;
-                mesh.vertices[point].pos = mesh.vertices[point].pos - ((elevation) * mesh.vertices[point].normal);
-                mesh.vertices[point].elevation = 0.0;
-            }
-        }
-    }
+    flattenPlates(CONTINENTAL);
     needBuffersUpdate=true;
 
     QRandomGenerator prng;
-    prng.seed(rdtsc());
+    prng.seed(nextSeed());
     qint32 offsetX = prng.bounded(0,10000), offsetY = prng.bounded(0,10000),offsetZ = prng.bounded(0,10000);
-    for(Plate &plate: plates){
-        if(plate.type == CONTINENTAL) 
+    elevatePlates(CONTINENTAL, QVector3D(offsetX, offsetY, offsetZ));
+}
+
+/**
+ * @brief Raises (or sinks when <b>direction</b> is negative) a vertex after a collision.
+ * The vertex keeps rising as long as its elevation is lower than <b>limit</b>.
+ *
+ * @return true if the vertex may have moved.
+ */
+static bool collide (QVector3D &pos, float &vertexElevation, const QVector3D &normal, float limit, float direction)
+{
+    double elevation = (vertexElevation) * 0.00013f;
+
+    if(vertexElevation < limit){
+
+        if(elevation < 0) [[unlikely]]
         {
-            for(const unsigned int &point : plate.points)
-            {
-                double rng = noise.fractal(octaveContinent,mesh.vertices[point].pos.x()+offsetX,mesh.vertices[point].pos.y()+offsetY,mesh.vertices[point].pos.z()+offsetZ)+0.5;
-                double elevation = (plateParams.continentalElevation)* rng;
-                mesh.vertices[point].pos = mesh.vertices[point].pos + ((elevation) * mesh.vertices[point].normal);
-                mesh.vertices[point].elevation = rng;
-            }
+            elevation = fabsf(elevation);
         }
+        vertexElevation += elevation;
+
+        pos = pos + ((direction * vertexElevation) * normal); // move the point along its normal.
+        return true;
     }
+    return false;
 }
 
 void Planet::move()
 {
-    std::vector<Vertex> vertex_cpy;
-    vertex_cpy.resize(mesh.vertices.size());
-    std::copy (mesh.vertices.begin(), mesh.vertices.end(), vertex_cpy.begin());
-    for(Plate &plate: plates)
-    {
-        if(plate.type == CONTINENTAL)
+    TRACE_SPAN("move");
+    applyRadius();
+    // Each vertex only reads the previous state, which is left untouched until the swap,
+    // and visits its neighbours in the sorted order of the one-ring: the step is the same on any number of threads.
+    // Only the positions and the elevations change.
+    const std::vector<QVector3D> &positions = mesh.positions, &normals = mesh.normals;
+    const std::vector<float> &elevations = mesh.elevations, &plateIds = mesh.plateIds;
+    nextPositions.resize(positions.size());
+    nextElevations.resize(elevations.size());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, positions.size(), 1024), [&](const tbb::blocked_range<size_t> &range){
+        TRACE_SPAN("movePoints");
+        for(size_t point = range.begin(); point != range.end(); ++point)
         {
-            for(const unsigned int &point : plate.points)
+            const QVector3D &current = positions[point];
+            const Plate &plate = plates[plateIds[point]];
+            QVector3D &pos = nextPositions[point];
+            float &elevation = nextElevations[point];
+            pos = current;
+            elevation = elevations[point];
+            bool changed = false;
+
+            for(unsigned int neighboring_vertex : one_ring[point])
             {
-                for(size_t i = 0; i< one_ring[point].size(); ++i)
-                {
-                    unsigned int neighboring_vertex = one_ring[point][i];
-                    // Checking the type of the plate of the neighboring vertex.
-                    if(plates[mesh.vertices[neighboring_vertex].plate_id].type==CONTINENTAL && 
-                    mesh.vertices[neighboring_vertex].plate_id != mesh.vertices[point].plate_id ) // Collision CONTINENT/CONTINENT
-                    {
-                        vertex_cpy[point].pos += plate.mouvement*100;
-                        //Check if the point would be closer after movement.
-                        if(dist(vertex_cpy[point].pos, mesh.vertices[neighboring_vertex].pos) < dist(mesh.vertices[point].pos, mesh.vertices[neighboring_vertex].pos))
-                        {
-                            double elevation = (mesh.vertices[point].elevation) * 0.00013f;
-
-                            if(mesh.vertices[point].elevation < 1.0f){
-
-                                if(elevation < 0) [[unlikely]]
-                                {
-                                    elevation = fabsf(elevation);
-                                }
-                                mesh.vertices[point].elevation += elevation;
+                const QVector3D &neighbour = positions[neighboring_vertex];
+                const Plate &neighbourPlate = plates[plateIds[neighboring_vertex]];
+                if(plateIds[neighboring_vertex] == plateIds[point])
+                    continue;
 
-                                mesh.vertices[point].pos = mesh.vertices[point].pos + ((mesh.vertices[point].elevation) * mesh.vertices[point].normal); // move the point along its normal.
-                            }
-                        }
-                    }
+                // Collision CONTINENT/CONTINENT or OCEANIC/OCEANIC: check if the point would be closer after movement.
+                if(neighbourPlate.type == plate.type)
+                {
+                    QVector3D moved = current + plate.mouvement*100;
+                    if(dist(moved, neighbour) < dist(current, neighbour))
+                        changed |= collide(pos, elevation, normals[point], 1.0f, plate.type == CONTINENTAL ? 1.0f : -1.0f);
                 }
-            }
-        }
 
-        if(plate.type == OCEANIC)
-        {
-            for(const unsigned int &point : plate.points)
-            {
-                for(size_t i = 0; i< one_ring[point].size(); ++i)
+                // Collision OCEANIC/CONTINENT: the continental point is raised by the oceanic one moving under it.
+                if(plate.type == CONTINENTAL && neighbourPlate.type == OCEANIC)
                 {
-                    unsigned int neighboring_vertex = one_ring[point][i];
-                    // Checking the type of the plate of the neighboring vertex.
-                    if(plates[mesh.vertices[neighboring_vertex].plate_id].type==OCEANIC && 
-                    mesh.vertices[neighboring_vertex].plate_id != mesh.vertices[point].plate_id ) // Collision OCEANIC/OCEANIC
-                    {
-                        vertex_cpy[point].pos += plate.mouvement*100;
-                        //Check if the point would be closer after movement.
-                        if(dist(vertex_cpy[point].pos, mesh.vertices[neighboring_vertex].pos) < dist(mesh.vertices[point].pos, mesh.vertices[neighboring_vertex].pos))
-                        {
-                            double elevation = (mesh.vertices[point].elevation) * 0.00013f;
-
-                            if(mesh.vertices[point].elevation < 1.0f){
-
-                                if(elevation < 0) [[unlikely]]
-                                {
-                                    elevation = fabsf(elevation);
-                                }
-                                mesh.vertices[point].elevation += elevation;
-
-                                mesh.vertices[point].pos = mesh.vertices[point].pos - ((mesh.vertices[point].elevation) * mesh.vertices[point].normal); // move the point along its normal.
-                            }
-                        }
-                    }
-
-                    if(plates[mesh.vertices[neighboring_vertex].plate_id].type==CONTINENTAL && 
-                    mesh.vertices[neighboring_vertex].plate_id != mesh.vertices[point].plate_id ) // Collision OCEANIC/CONTINENT
-                    {
-                        vertex_cpy[point].pos += plate.mouvement*200;
-                        //Check if the point would be closer after movement.
-                        if(dist(vertex_cpy[point].pos, mesh.vertices[neighboring_vertex].pos) < dist(mesh.vertices[point].pos, mesh.vertices[neighboring_vertex].pos))
-                        {
-
-                           double elevation = (mesh.vertices[neighboring_vertex].elevation) * 0.00013f;
-
-                            if(mesh.vertices[neighboring_vertex].elevation < 2.0f){
-
-                                if(elevation < 0) [[unlikely]]
-                                {
-                                    elevation = fabsf(elevation);
-                                }
-                                mesh.vertices[neighboring_vertex].elevation += elevation;
-
-                                mesh.vertices[neighboring_vertex].pos = mesh.vertices[neighboring_vertex].pos + ((mesh.vertices[neighboring_vertex].elevation) * mesh.vertices[neighboring_vertex].normal); // move the point along its normal.
-                            }
-                        }
-                    }
+                    QVector3D moved = neighbour + neighbourPlate.mouvement*200;
+                    if(dist(moved, current) < dist(neighbour, current))
+                        changed |= collide(pos, elevation, normals[point], 2.0f, 1.0f);
                 }
             }
+            if(changed) // only the vertices of the plate boundaries need to be uploaded
+            {
+                mesh.markDirty(POSITION, point, point + 1);
+                mesh.markDirty(ELEVATION, point, point + 1);
+            }
         }
-    }
+    });
+    mesh.positions.swap(nextPositions);
+    mesh.elevations.swap(nextElevations);
+    ++steps;
 
     needBuffersUpdate=true;
 }
 
 void Planet::closestPoint(QVector3D point)
 {
+    TRACE_SPAN("closestPoint");
+    if(grid.empty())
+        return;
+    applyRadius();
+
     float cloestDist = std::numeric_limits<float>::max();
     size_t idClosest = 0;
+    auto closest = [&](const std::vector<unsigned int> &candidates){
+        for(unsigned int i : candidates)
+        {
+            float dist_ =dist(mesh.positions[i],point);
 
-    for(size_t i = 0; i < mesh.vertices.size(); i++)
-    {
-        const QVector3D &p = mesh.vertices[i].pos;
+            if(cloestDist > dist_ || (cloestDist == dist_ && i < idClosest))
+            {
+                cloestDist = dist_;
+                idClosest = i;
+            }
+        }
+    };
 
+    // The vertices only move along their normal, on the outer side of the center: a vertex whose direction
+    // makes an angle a with the one of the point is at least |point| * sin(a) away from it. Starting from
+    // the vertex of closest direction, only the directions within the angle allowed by its distance are checked.
+    const QVector3D direction = point.normalized();
+    const float length = point.length();
+    std::vector<unsigned int> candidates;
+    grid.kNearest(direction, 1, candidates);
+    closest(candidates);
 
-        float dist_ =dist(p,point);
+    float chord = 2.0f;
+    if(cloestDist < length)
+        chord = std::min(2.0f, 2.0f * sinf(asinf(cloestDist / length) / 2.0f) * 1.0001f + 1e-6f);
+    grid.radiusSearch(direction, chord, candidates);
+    closest(candidates);
 
-        if(cloestDist > dist_)
-        {
-            cloestDist = dist_;
-            idClosest = i;
-        }
-    }
-    selectedPlateID = mesh.vertices[idClosest].plate_id;
+    selectedPlateID = mesh.plateIds[idClosest];
 
     std::cout<< "Selected plate n°"<<selectedPlateID<<std::endl;
 }
@@ -623,6 +640,7 @@ void Planet::drawPlanet(const qglviewer::Camera *camera)
     program->setUniformValue(program->uniformLocation("lighting"), int(shaderLighting));
     program->setUniformValue(program->uniformLocation("selected_plate"), selectedPlateID);
     program->setUniformValue(program->uniformLocation("texRender"), int(textures));
+    program->setUniformValue(program->uniformLocation("radius_offset"), float(radius - meshRadius));
 
     mesh.Draw(program);
     program->release();
@@ -651,6 +669,7 @@ void Planet::drawOcean(const qglviewer::Camera *camera)
     oceanProgram->setUniformValue(oceanProgram->uniformLocation("viewPos"), camPos);
     oceanProgram->setUniformValue(oceanProgram->uniformLocation("lightPos"), camPos);
     oceanProgram->setUniformValue(oceanProgram->uniformLocation("lighting"), int(this->shaderLighting));
+    oceanProgram->setUniformValue(oceanProgram->uniformLocation("radius_offset"), float(radius - oceanRadius));
 
     oceanMesh.Draw(oceanProgram);
     oceanProgram->release();
@@ -666,7 +685,9 @@ void Planet::draw (const qglviewer::Camera *camera)
         //mesh.setTextures(program);
         if(!oceanMesh.VAO->isCreated())[[unlikely]]
             oceanMesh.setupMesh(oceanProgram);
-        oceanMesh.vertices.clear();
+        else
+            oceanMesh.attachIndices(); // the planet's index buffer has been recreated
+        oceanMesh.clearVertices();
         needInitBuffers = false;
     } else { [[likely]]
         if(oceanDraw)
@@ -683,75 +704,61 @@ void Planet::clear ()
 {
 	if (planetCreated)
     {
+        // The triangulation, the one-ring and the grid only depend on the points of the sphere: they are kept.
+        std::vector<unsigned int> indices;
+        indices.swap(mesh.indices);
         plates.clear();
         mesh.clear();
+        mesh.indices.swap(indices);
         oceanMesh.clear();
-        one_ring.clear();
 
 		planetCreated = false;
         needInitBuffers = true;
 	}
 }
 
-void Planet::save () const
+bool Planet::save (const std::string &filename) const
 {
-	std::string filename = "planet.obj";
-	std::ofstream ostream;
-	ostream.precision (4);
-
-	ostream.open (filename, std::ios_base::out);
-	ostream << "o planet" << std::endl;
-    for (size_t i = 0; i < mesh.vertices.size (); ++i)
-	{
-        ostream << "v " << std::fixed << mesh.vertices[i].pos.x () << " "
-            << std::fixed << mesh.vertices[i].pos.y () << " " << std::fixed
-            << mesh.vertices[i].pos.z () << std::endl;
-	}
-
-    for (size_t i = 0; i < mesh.vertices.size (); ++i)
-	{
-        ostream << "vn " << mesh.vertices[i].normal.x () << " "
-            << mesh.vertices[i].normal.y () << " " << mesh.vertices[i].normal.z ()
-			<< std::endl;
+    if(!exportOBJ(mesh, filename))
+    {
+        std::cerr << "Couldn't write to file " << filename << std::endl;
+        return false;
     }
+    std::cout << "Wrote to file " << filename << std::endl;
+    return true;
+}
 
-    for (size_t i = 0; i < mesh.indices.size (); i += 3)
+bool Planet::saveOFF (const std::string &filename) const
+{
+    if(!exportOFF(mesh, filename))
     {
-        ostream << "f " << mesh.indices[i] << " " << mesh.indices[i + 1] << " "
-            << mesh.indices[i + 2] << std::endl;
-	}
-	ostream.close ();
-
+        std::cerr << "Couldn't write to file " << filename << std::endl;
+        return false;
+    }
     std::cout << "Wrote to file " << filename << std::endl;
+    return true;
 }
 
-void Planet::saveOFF () const
+bool Planet::savePLY (const std::string &filename) const
 {
-    std::string filename = "planet.off";
-	std::ofstream ostream;
-	ostream.precision (4);
-
-	ostream.open (filename, std::ios_base::out);
-
-	ostream << "OFF " << std::endl;
-    ostream << (mesh.vertices.size ()) << " " << mesh.indices.size () << " 0"
-		<< std::endl;
-
-    for (size_t i = 0; i < mesh.vertices.size (); ++i)
-	{
-        ostream << mesh.vertices[i].pos.x () << " " << mesh.vertices[i].pos.y () << " "
-            << mesh.vertices[i].pos.z () << std::endl;
-	}
-
-    for (size_t t = 0; t < mesh.indices.size (); t += 3)
-	{
-        ostream << "3 " << (mesh.indices[t]) << " " << (mesh.indices[t + 1]) << " "
-            << (mesh.indices[t + 2]) << std::endl;
-	}
-
-	ostream.close ();
+    if(!exportPLY(mesh, filename))
+    {
+        std::cerr << "Couldn't write to file " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Wrote to file " << filename << std::endl;
+    return true;
+}
 
+bool Planet::saveGLB (const std::string &filename) const
+{
+    if(!exportGLB(mesh, filename))
+    {
+        std::cerr << "Couldn't write to file " << filename << std::endl;
+        return false;
+    }
     std::cout << "Wrote to file " << filename << std::endl;
+    return true;
 }
 
 void Planet::setOceanicElevation (double _e)
@@ -775,14 +782,42 @@ void Planet::setPlateNumber (int _plateNum)
   std::cout << "planet plate number: " << this->plateNum << std::endl;
 }
 
+void Planet::setConcurrentGrowth (bool _concurrent)
+{
+  this->concurrentGrowth = _concurrent;
+}
+
+void Planet::setSeed (quint64 _seed)
+{
+  this->fixedSeed = true;
+  this->seed = _seed;
+  this->seedStream = 0;
+
+  std::cout << "planet seed set to " << this->seed << std::endl;
+}
+
 void Planet::setRadius (double _r)
 {
   this->radius = _r*1000;
-    needInitBuffers = true;
 
   std::cout << "planet radius set to " << this->radius << std::endl;
 }
 
+void Planet::applyRadius ()
+{
+    if(meshRadius == radius || mesh.positions.empty())
+        return;
+    // The elevations are offsets along the normals, which the radius does not change.
+    const float offset = radius - meshRadius;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, mesh.positions.size(), 4096), [&](const tbb::blocked_range<size_t> &range){
+        for(size_t i = range.begin(); i != range.end(); ++i)
+            mesh.positions[i] += offset * mesh.normals[i];
+    });
+    mesh.markDirty(POSITION);
+    meshRadius = radius;
+    needBuffersUpdate = true;
+}
+
 double Planet::getRadius() const
 {
     return this->radius;
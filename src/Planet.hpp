@@ -7,40 +7,91 @@
 #include <QGLViewer/camera.h>
 #include <QVector3D>
 #include <QVector2D>
-#include <chrono>
-#include <set>
-#include <CGAL/mesh_segmentation.h>
-#include <CGAL/Point_set_3.h>
-#include <CGAL/Advancing_front_surface_reconstruction.h>
 
 #include "Plate.hpp"
 #include "Mesh.hpp"
 #include "Noise.hpp"
-
-typedef CGAL::Simple_cartesian<double>                  K;
-typedef K::Point_3                                      Point;
-typedef CGAL::Point_set_3<Point>                        Point_set;
+#include "OneRing.hpp"
+#include "SphereGrid.hpp"
 
 /**
  * @brief Planet Class.
  * Class reprensenting a planet.
  */
 class Planet{
+friend class PlanetBench;
 private:
 	unsigned int plateNum;
 	double radius;
 	int elems;
     SimplexNoise noise;
     unsigned int octaveOcean, octaveContinent;
-
-    std::vector<QVector3D> pos;
-    std::vector<std::vector<unsigned int> >  one_ring;
+    bool fixedSeed = false;
+    quint64 seed = 0, seedStream = 0;
+
+    std::vector<QVector3D> pos; // positions of the points on the unit sphere
+    OneRing one_ring;
+    SphereGrid grid; // index of pos, which stays valid as the vertices only move along their normal
+    bool concurrentGrowth = true;
+    std::vector<unsigned int> plateOwner;
+    std::vector<std::vector<unsigned int> > frontiers, nextFrontiers;
+    std::vector<QVector3D> nextPositions; // back buffers of the tectonic step
+    std::vector<float> nextElevations;
+    unsigned long long steps = 0; // number of movement steps since the generation
+    int topologyElems = 0;        // number of points of the sphere whose triangulation, one-ring and grid are kept by clear()
+    double meshRadius = 0, oceanRadius = 0; // radius of the positions of the meshes, which are drawn moved to the current radius
 
     /**
      * @brief triangulation method.
-     * Uses the surface reconstruction of CGAL with the positions of created with makeSphere() method.
+     * Computes the Delaunay triangulation of the points created with the makeSphere() method.
      */
     void triangulate();
+
+    /**
+     * @brief Indexes the points of the sphere in the grid used by closestPoint().
+     */
+    void buildGrid();
+
+    /**
+     * @brief Reads the triangulation and the one-ring of the sphere from the TopologyCache, instead of
+     * computing them. The cache is written by initPlanet() after computing them.
+     *
+     * @return true if the cache file of the number of points was valid.
+     */
+    bool loadTopology();
+
+    /**
+     * @brief Tells whether the triangulation, the one-ring and the grid kept from the previous generation
+     * are the ones of the current number of points, in which case a generation only reruns the stages
+     * which depend on the plates and the noise. The points on the unit sphere do not depend on the radius.
+     *
+     * @return true if the topology can be reused.
+     */
+    bool hasTopology () const;
+
+    /**
+     * @brief Returns the seed of the next random generator.
+     * The seed is derived from the one given to setSeed() or from the timestamp counter if none was given.
+     *
+     * @return quint64
+     */
+    quint64 nextSeed ();
+
+    /**
+     * @brief Moves the points of the plates of the given type along their normal according to fractal noise.
+     * The plates and their points are processed in parallel, each point only depending on its own position.
+     *
+     * @param type the type of the plates to elevate.
+     * @param offset the offset added to the positions, which selects a different part of the noise.
+     */
+    void elevatePlates (PlateType type, const QVector3D &offset);
+
+    /**
+     * @brief Moves the points of the plates of the given type back to the sphere and resets their elevation.
+     *
+     * @param type the type of the plates to flatten.
+     */
+    void flattenPlates (PlateType type);
     /**
      * @brief method to draw the planet surface.
      * 
@@ -64,10 +115,12 @@ public:
     QOpenGLShaderProgram *program=nullptr, *oceanProgram = nullptr;
     GLuint programID, oceanProgramID;
     bool planetCreated=false;
-    std::chrono::time_point<std::chrono::system_clock> start, end;
-    std::chrono::duration<double> elapsed_seconds;
 
-    Planet (){}
+    /**
+     * @brief Construct a planet without any OpenGL resources.
+     * Such a planet can be generated and simulated but not drawn, which is what the headless mode relies on.
+     */
+    Planet ();
     Planet (QOpenGLContext *context);
 	~Planet ();
 
@@ -97,7 +150,8 @@ public:
 
     /**
      * @brief Method initilizing the plates
-     * This method segments the mesh in different regions.
+     * This method segments the mesh in different regions by growing the plates from random seeds,
+     * one level of neighbours at a time.
      */
     void makePlates ();
 
@@ -125,17 +179,6 @@ public:
      */
     void initPlanet ();
 
-    /**
-     * @brief Method to get the one_ring of each vertices of the mesh.
-     * 
-     * @param i_vertices 
-     * @param i_triangles 
-     * @param o_one_ring 
-     */
-    void collect_one_ring (std::vector<QVector3D> const & i_vertices,
-    std::vector< unsigned int > const & i_triangles,
-    std::vector<std::vector<unsigned int> > & o_one_ring);
-
     /**
     * @brief Method to draw the whole planet.
     * 
@@ -145,21 +188,59 @@ public:
 
     /**
     * @brief Method to clear the planet.
-    * 
+    * The topology of the sphere is kept, so that the next generation with as many points reuses it.
     */
 	void clear ();
 
     /**
      * @brief Method to save the mesh as an .obj file.
      * 
+     * @param filename 
+     * @return true if the file was written.
      */
-	void save () const;
+	bool save (const std::string &filename = "planet.obj") const;
+
+    /**
+     * @brief Method to save the whole state of the planet as a binary snapshot.
+     * Unlike the .obj and .off files, the snapshot is exact and can be loaded back to resume the simulation.
+     * 
+     * @param filename 
+     * @return true if the file was written.
+     */
+    bool saveSnapshot (const std::string &filename = "planet.bin") const;
+
+    /**
+     * @brief Method to replace the planet by a snapshot written by saveSnapshot().
+     * The file is mapped in memory and checked before any of the planet is modified.
+     * 
+     * @param filename 
+     * @return true if the snapshot was loaded.
+     */
+    bool loadSnapshot (const std::string &filename = "planet.bin");
 
     /**
      * @brief Method to save the mesh as an .off file.
      * 
+     * @param filename 
+     * @return true if the file was written.
      */
-	void saveOFF () const;
+	bool saveOFF (const std::string &filename = "planet.off") const;
+
+    /**
+     * @brief Method to save the mesh as a binary .ply file, with the elevation and the plate id of the vertices.
+     * 
+     * @param filename 
+     * @return true if the file was written.
+     */
+    bool savePLY (const std::string &filename = "planet.ply") const;
+
+    /**
+     * @brief Method to save the mesh as a binary glTF file, with the elevation and the plate id of the vertices.
+     * 
+     * @param filename 
+     * @return true if the file was written.
+     */
+    bool saveGLB (const std::string &filename = "planet.glb") const;
 
     /**
      * @brief Set the Plate Number object
@@ -168,13 +249,38 @@ public:
      */
 	void setPlateNumber (int _plateNum);
 
+    /**
+     * @brief Set whether the plates grow concurrently during the segmentation.
+     * The segmentation is the same either way.
+     *
+     * @param _concurrent 
+     */
+    void setConcurrentGrowth (bool _concurrent);
+
+    /**
+     * @brief Set the seed used by the plate segmentation and the elevation noise.
+     * Two generations with the same seed and parameters give the same planet.
+     *
+     * @param _seed 
+     */
+    void setSeed (quint64 _seed);
+
     /**
      * @brief Set the Radius object
+     * The planet is not generated again: its vertices are drawn moved along their normal to the new radius,
+     * and only moved on the CPU by applyRadius().
      * 
-     * @param _r 
+     * @param _r the radius in km.
      */
 	void setRadius (double _r);
 
+    /**
+     * @brief Moves the vertices of the planet to the current radius, if it changed since they were computed.
+     * The methods reading the positions of the vertices, like move() and closestPoint(), call it first,
+     * and so must the code copying them.
+     */
+    void applyRadius ();
+
     /**
      * @brief Get the Radius object
      * 
@@ -182,6 +288,13 @@ public:
      */
     double getRadius () const;
 
+    /**
+     * @brief Get the number of movement steps since the generation
+     * 
+     * @return unsigned long long 
+     */
+    unsigned long long getSteps () const { return steps; }
+
     /**
      * @brief Set the Elems object
      * 
@@ -230,21 +343,22 @@ public:
     void reelevateContinent();
 
     /**
-    * @brief 
-    * 
+    * @brief Method computing one step of the plates movement.
+    * The step is computed in parallel from the previous state into a back buffer which then replaces the vertices.
     */
     void move();
 
     /**
-     * @brief 
-     * 
-     * @param point 
-     * @param mesh 
+     * @brief Selects the plate of the vertex closest to a point.
+     * Only the vertices whose direction is close enough to the one of the point to possibly be
+     * the closest are looked up in the grid, which stays valid as the plates move.
+     *
+     * @param point a point near the surface of the planet.
      */
     void closestPoint(QVector3D point);
 
-    QOpenGLContext *glContext;
-    QOpenGLExtraFunctions *glFunctions;
+    QOpenGLContext *glContext = nullptr;
+    QOpenGLExtraFunctions *glFunctions = nullptr;
 
     static void /*GLAPIENTRY */ MessageCallback (GLenum source, GLenum type,
                           GLuint id, GLenum severity,
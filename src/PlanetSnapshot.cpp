@@ -0,0 +1,198 @@
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <QFile>
+
+#include "Planet.hpp"
+#include "PlanetSnapshot.hpp"
+#include "Trace.hpp"
+
+#define PI 3.14159265358979323846
+
+using namespace PlanetSnapshot;
+
+bool Planet::saveSnapshot (const std::string &filename) const
+{
+    TRACE_SPAN("saveSnapshot");
+
+    std::vector<PlateEntry> plateTable(plates.size());
+    for(size_t p = 0; p < plates.size(); ++p)
+    {
+        const Plate &plate = plates[p];
+        plateTable[p] = {quint32(plate.type), {plate.mouvement.x(), plate.mouvement.y(), plate.mouvement.z()}, plate.e};
+    }
+
+    const std::span<const unsigned int> ringOffsets = one_ring.rowOffsets(), ringNeighbours = one_ring.allNeighbours();
+    const std::pair<const void *, size_t> data[SECTION_COUNT] = {
+        {mesh.positions.data(), mesh.positions.size() * sizeof(QVector3D)},
+        {mesh.normals.data(), mesh.normals.size() * sizeof(QVector3D)},
+        {mesh.texCoords.data(), mesh.texCoords.size() * sizeof(QVector2D)},
+        {mesh.elevations.data(), mesh.elevations.size() * sizeof(float)},
+        {mesh.plateIds.data(), mesh.plateIds.size() * sizeof(float)},
+        {mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int)},
+        {ringOffsets.data(), ringOffsets.size_bytes()},
+        {ringNeighbours.data(), ringNeighbours.size_bytes()},
+        {plateTable.data(), plateTable.size() * sizeof(PlateEntry)}
+    };
+
+    Header header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.sectionCount = SECTION_COUNT;
+    header.steps = steps;
+    header.radius = meshRadius; // the one of the positions
+    header.oceanicElevation = plateParams.oceanicElevation;
+    header.continentalElevation = plateParams.continentalElevation;
+    header.octaveOcean = octaveOcean;
+    header.octaveContinent = octaveContinent;
+
+    SectionEntry table[SECTION_COUNT];
+    quint64 offset = sizeof(Header) + sizeof(table);
+    for(quint32 s = 0; s < SECTION_COUNT; ++s)
+    {
+        table[s].offset = (offset + 15) & ~quint64(15);
+        table[s].bytes = data[s].second;
+        offset = table[s].offset + table[s].bytes;
+    }
+
+    // Every array is written as is, one after the other.
+    std::ofstream ostream(filename, std::ios_base::out | std::ios_base::binary);
+    ostream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    ostream.write(reinterpret_cast<const char *>(table), sizeof(table));
+    offset = sizeof(Header) + sizeof(table);
+    const char padding[16] = {};
+    for(quint32 s = 0; s < SECTION_COUNT; ++s)
+    {
+        ostream.write(padding, table[s].offset - offset);
+        ostream.write(static_cast<const char *>(data[s].first), data[s].second);
+        offset = table[s].offset + table[s].bytes;
+    }
+    ostream.close();
+
+    if(!ostream) [[unlikely]]
+    {
+        std::cerr << "Couldn't write the snapshot " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Planet::loadSnapshot (const std::string &filename)
+{
+    TRACE_SPAN("loadSnapshot");
+
+    QFile file(QString::fromStdString(filename));
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        std::cerr << "Couldn't open the snapshot " << filename << std::endl;
+        return false;
+    }
+    const quint64 size = file.size();
+    const uchar *mapping = size > sizeof(Header) ? file.map(0, size) : nullptr;
+    auto invalid = [&](const char *reason){
+        std::cerr << "Invalid snapshot " << filename << ": " << reason << std::endl;
+        return false;
+    };
+    if(!mapping)
+        return invalid("too short");
+
+    Header header;
+    memcpy(&header, mapping, sizeof(Header));
+    if(memcmp(header.magic, magic, sizeof(magic)) != 0)
+        return invalid("not a snapshot");
+    if(header.version != version || header.byteOrderMark != byteOrderMark || header.sectionCount != SECTION_COUNT)
+        return invalid("unsupported version or byte order");
+
+    SectionEntry table[SECTION_COUNT];
+    if(size < sizeof(Header) + sizeof(table))
+        return invalid("truncated");
+    memcpy(table, mapping + sizeof(Header), sizeof(table));
+    for(const SectionEntry &section : table)
+    {
+        if(section.offset > size || section.bytes > size - section.offset || section.offset % 16 != 0)
+            return invalid("truncated");
+    }
+
+    // The sections are aligned: they are read in place from the mapping.
+    auto section = [&](Section s){ return mapping + table[s].offset; };
+    auto count = [&](Section s, size_t elementSize){ return table[s].bytes / elementSize; };
+    const size_t vertexCount = count(POSITIONS, sizeof(QVector3D));
+    const size_t plateCount = count(PLATES, sizeof(PlateEntry));
+    const size_t neighbourCount = count(RING_NEIGHBOURS, sizeof(unsigned int));
+    if(vertexCount < 4 || plateCount == 0
+        || table[POSITIONS].bytes != vertexCount * sizeof(QVector3D)
+        || table[NORMALS].bytes != vertexCount * sizeof(QVector3D)
+        || table[TEXTURE_COORDS].bytes != vertexCount * sizeof(QVector2D)
+        || table[ELEVATIONS].bytes != vertexCount * sizeof(float)
+        || table[PLATE_IDS].bytes != vertexCount * sizeof(float)
+        || table[INDICES].bytes % (3 * sizeof(unsigned int)) != 0
+        || table[RING_OFFSETS].bytes != (vertexCount + 1) * sizeof(unsigned int)
+        || table[RING_NEIGHBOURS].bytes != neighbourCount * sizeof(unsigned int)
+        || table[PLATES].bytes != plateCount * sizeof(PlateEntry))
+        return invalid("inconsistent sizes");
+
+    const float *plateIds = reinterpret_cast<const float *>(section(PLATE_IDS));
+    const unsigned int *indices = reinterpret_cast<const unsigned int *>(section(INDICES));
+    const unsigned int *ringOffsets = reinterpret_cast<const unsigned int *>(section(RING_OFFSETS));
+    const unsigned int *ringNeighbours = reinterpret_cast<const unsigned int *>(section(RING_NEIGHBOURS));
+    const size_t indexCount = count(INDICES, sizeof(unsigned int));
+    for(size_t v = 0; v < vertexCount; ++v)
+    {
+        if(!(plateIds[v] >= 0 && plateIds[v] < plateCount) || ringOffsets[v] > ringOffsets[v + 1])
+            return invalid("corrupted vertices");
+    }
+    if(ringOffsets[0] != 0 || ringOffsets[vertexCount] != neighbourCount
+        || std::any_of(indices, indices + indexCount, [&](unsigned int i){ return i >= vertexCount; })
+        || std::any_of(ringNeighbours, ringNeighbours + neighbourCount, [&](unsigned int i){ return i >= vertexCount; }))
+        return invalid("corrupted topology");
+    const PlateEntry *plateTable = reinterpret_cast<const PlateEntry *>(section(PLATES));
+    if(std::any_of(plateTable, plateTable + plateCount, [](const PlateEntry &plate){ return plate.type != OCEANIC && plate.type != CONTINENTAL; }))
+        return invalid("corrupted plates");
+
+    // The snapshot is valid: it replaces the current planet.
+    planetCreated = false;
+    plates.clear();
+    mesh.clear();
+    oceanMesh.clear();
+    grid.clear();
+    needInitBuffers = true;
+
+    mesh.resize(vertexCount);
+    memcpy(mesh.positions.data(), section(POSITIONS), table[POSITIONS].bytes);
+    memcpy(mesh.normals.data(), section(NORMALS), table[NORMALS].bytes);
+    memcpy(mesh.texCoords.data(), section(TEXTURE_COORDS), table[TEXTURE_COORDS].bytes);
+    memcpy(mesh.elevations.data(), section(ELEVATIONS), table[ELEVATIONS].bytes);
+    memcpy(mesh.plateIds.data(), plateIds, table[PLATE_IDS].bytes);
+    mesh.indices.assign(indices, indices + indexCount);
+    one_ring.assign(std::span<const unsigned int>(ringOffsets, vertexCount + 1), std::span<const unsigned int>(ringNeighbours, neighbourCount));
+
+    plates.resize(plateCount);
+    for(size_t p = 0; p < plateCount; ++p)
+    {
+        plates[p].type = PlateType(plateTable[p].type);
+        plates[p].mouvement = QVector3D(plateTable[p].mouvement[0], plateTable[p].mouvement[1], plateTable[p].mouvement[2]);
+        plates[p].e = plateTable[p].e;
+    }
+    for(size_t v = 0; v < vertexCount; ++v)
+        plates[size_t(plateIds[v])].points.push_back(v);
+
+    elems = vertexCount;
+    plateNum = plateCount;
+    radius = header.radius;
+    plateParams.oceanicElevation = header.oceanicElevation;
+    plateParams.continentalElevation = header.continentalElevation;
+    octaveOcean = header.octaveOcean;
+    octaveContinent = header.octaveContinent;
+    steps = header.steps;
+
+    // The directions of the vertices are their normals, from which the grid and the ocean are rebuilt.
+    pos = mesh.normals;
+    grid.build(pos, 2 * sqrt(4 * PI / pos.size()));
+    makeOcean();
+    topologyElems = elems;
+    meshRadius = radius;
+    planetCreated = true;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef PLANETSNAPSHOT_H
+#define PLANETSNAPSHOT_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Layout of the binary snapshots written by Planet::saveSnapshot().
+ * A snapshot is a Header followed by a table of sectionCount SectionEntry, then the sections,
+ * each one being a raw array of the planet aligned on 16 bytes. The values are stored in the byte
+ * order of the machine, which the header records, so that loading only maps the file and copies
+ * the arrays. Adding a section or changing one of them requires a new version.
+ */
+namespace PlanetSnapshot
+{
+    const char magic[4] = {'P', 'L', 'N', 'T'};
+    const quint32 version = 1;
+    const quint32 byteOrderMark = 0x01020304;
+
+    /**
+     * @brief Sections of a snapshot, in the order of the section table.
+     */
+    enum Section : quint32 {
+        POSITIONS,       // QVector3D per vertex
+        NORMALS,         // QVector3D per vertex, the directions of the vertices on the unit sphere
+        TEXTURE_COORDS,  // QVector2D per vertex
+        ELEVATIONS,      // float per vertex
+        PLATE_IDS,       // float per vertex
+        INDICES,         // three unsigned int per triangle
+        RING_OFFSETS,    // unsigned int per vertex, plus one
+        RING_NEIGHBOURS, // unsigned int per edge end
+        PLATES,          // PlateEntry per plate
+        SECTION_COUNT
+    };
+
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        quint32 byteOrderMark;
+        quint32 sectionCount;
+        quint64 steps;       // number of movement steps simulated since the generation
+        double radius;
+        float oceanicElevation, continentalElevation;
+        quint32 octaveOcean, octaveContinent;
+    };
+
+    struct SectionEntry
+    {
+        quint64 offset; // from the start of the file
+        quint64 bytes;
+    };
+
+    /**
+     * @brief A plate, whose points are the vertices with its index in the PLATE_IDS section.
+     */
+    struct PlateEntry
+    {
+        quint32 type;
+        float mouvement[3];
+        float e;
+    };
+}
+
+#endif // PLANETSNAPSHOT_H
@@ -1,8 +1,9 @@
 #include "PlanetViewer.hpp"
+#include "ShaderProgram.hpp"
+#include "Trace.hpp"
 #include <cfloat>
 #include <QFileDialog>
 #include <QGLViewer/manipulatedCameraFrame.h>
-#include <filesystem>
 #include <GL/glu.h> 
 
 
@@ -13,27 +14,7 @@ PlanetViewer::PlanetViewer (QWidget *parent) : QGLViewer (parent)
 void PlanetViewer::init ()
 {
     planet = Planet (QOpenGLContext::currentContext ());
-    skyboxShader = new QOpenGLShaderProgram();
-    std::filesystem::path fs = std::filesystem::current_path ();
-    std::string path = fs.string () + "/GLSL/shaders/";
-    QString  vShaderPath = QString::fromStdString(path + "skybox.vert");
-    QString  fShaderPath = QString::fromStdString(path + "skybox.frag");
-    if(!skyboxShader->addShaderFromSourceFile(QOpenGLShader::Vertex,vShaderPath))
-    {
-        std::cerr<<skyboxShader->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add VERTEX shader"<<std::endl;
-    }
-    if(!skyboxShader->addShaderFromSourceFile(QOpenGLShader::Fragment,fShaderPath))
-    {
-        std::cerr<<skyboxShader->log().toStdString()<<std::endl;
-        std::cerr<<"Couldn't add FRAGMENT shader"<<std::endl;
-    }
-
-    if(!skyboxShader->link())
-    {
-        std::cerr<<skyboxShader->log().toStdString()<<std::endl;
-        std::cerr<<"Error linking program"<<std::endl;
-    }
+    skyboxShader = loadShaderProgram("skybox");
     skyboxShader->bind();
 
     skyboxTextureID = loadCubemap();
@@ -77,6 +58,8 @@ void PlanetViewer::init ()
 
 void PlanetViewer::drawSkybox()
 {
+    if(!skyboxFaceImages.empty())
+        uploadCubemap();
     glDepthMask(GL_FALSE);
     glDepthFunc(GL_LEQUAL);
     skyboxShader->bind();
@@ -143,26 +126,18 @@ void PlanetViewer::draw ()
 
 unsigned int PlanetViewer::loadCubemap()
 {
+    // The faces show the background color until all of them are loaded, as a cube map needs faces of the same size.
+    static const unsigned char placeholder[3] = {20, 20, 20};
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    skyboxFaceImages.clear();
 	for (unsigned int i = 0; i < skyboxFaces.size(); i++)
 	{
-        QImage texture = QImage(skyboxFaces[i].c_str());
-        texture = texture.convertToFormat(QImage::Format_RGB888);
-		unsigned char *data = texture.bits();
-		if (data)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 
-                        0, GL_RGB, texture.width(), texture.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, data
-			);
-		}
-		else
-		{
-			std::cout << "Cubemap tex failed to load at path: " << skyboxFaces[i] << std::endl;
-		}
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+        skyboxFaceImages.push_back(loadMipChain(QString::fromStdString(skyboxFaces[i])));
 	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -171,11 +146,36 @@ unsigned int PlanetViewer::loadCubemap()
 	return textureID;
 }  
 
+void PlanetViewer::uploadCubemap()
+{
+    for (const QFuture<MipChain> &face : skyboxFaceImages)
+    {
+        if (!face.isFinished())
+            return;
+    }
+	glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTextureID);
+	for (unsigned int i = 0; i < skyboxFaceImages.size(); i++)
+	{
+        const MipChain texture = skyboxFaceImages[i].result();
+		if (!texture.isNull())
+		{
+			texture.upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+		}
+		else
+		{
+			std::cout << "Cubemap tex failed to load at path: " << skyboxFaces[i] << std::endl;
+		}
+	}
+    skyboxFaceImages.clear();
+}
 
 void PlanetViewer::clear ()
 {
 	if(!generationFuture.isRunning()){
+        // The buffers of the planet are deleted in the context of the viewer.
+        makeCurrent ();
         planet.clear ();planetCreated =false;
+        doneCurrent ();
 		update ();
 	}
 }
@@ -191,7 +191,6 @@ void PlanetViewer::setPlateNumber (int _plateNum)
 void PlanetViewer::setPlanetRadius (QString _r)
 {
 	if(!generationFuture.isRunning()){
-        planet.clear ();
         planet.setRadius (_r.toDouble ());
 		update ();
 	}
@@ -207,11 +206,12 @@ void PlanetViewer::setPlanetElem (QString _elems)
 
 void PlanetViewer::generatePlanet ()
 {
-    
-    if (planet.planetCreated){
-        planet.clear ();
-    }
 	if(!generationFuture.isRunning()){
+        if (planet.planetCreated){
+            makeCurrent ();
+            planet.clear ();
+            doneCurrent ();
+        }
         displayMessage	("Generating planet...",-1);
 		generationFuture = QtConcurrent::run(
         [this]{
@@ -223,7 +223,9 @@ void PlanetViewer::generatePlanet ()
 void PlanetViewer::clearPlanet ()
 {
 	if(!generationFuture.isRunning()){
+        makeCurrent ();
         planet.clear ();
+        doneCurrent ();
         displayMessage	("Planet cleared");
 		update ();
 	}
@@ -328,14 +330,72 @@ void PlanetViewer::updateCamera (const qglviewer::Vec &center)
 
 void PlanetViewer::savePlanetOff ()
 {
-    displayMessage	("Planet saved as planet.off");
-    planet.saveOFF ();
+    if(!generationFuture.isRunning() && planet.planetCreated){
+        planet.applyRadius ();
+        exportQueue.enqueue (ExportQueue::OFF, planet.mesh, "planet.off");
+    }
 }
 
 void PlanetViewer::savePlanetObj ()
 {
-    displayMessage	("Planet saved as planet.obj");
-    planet.save ();
+    if(!generationFuture.isRunning() && planet.planetCreated){
+        planet.applyRadius ();
+        exportQueue.enqueue (ExportQueue::OBJ, planet.mesh, "planet.obj");
+    }
+}
+
+void PlanetViewer::savePlanetPly ()
+{
+    if(!generationFuture.isRunning() && planet.planetCreated){
+        planet.applyRadius ();
+        exportQueue.enqueue (ExportQueue::PLY, planet.mesh, "planet.ply");
+    }
+}
+
+void PlanetViewer::savePlanetGlb ()
+{
+    if(!generationFuture.isRunning() && planet.planetCreated){
+        planet.applyRadius ();
+        exportQueue.enqueue (ExportQueue::GLB, planet.mesh, "planet.glb");
+    }
+}
+
+void PlanetViewer::savePlanetSnapshot ()
+{
+    if(!generationFuture.isRunning() && planet.planetCreated){
+        planet.applyRadius ();
+        if(planet.saveSnapshot ())
+            displayMessage	("Planet saved as planet.bin");
+        else
+            displayMessage	("Couldn't save planet.bin");
+    }
+}
+
+void PlanetViewer::loadPlanetSnapshot ()
+{
+    if(!generationFuture.isRunning()){
+        makeCurrent ();
+        const bool loaded = planet.loadSnapshot ();
+        doneCurrent ();
+        if(loaded){
+            planetCreated = false;
+            years = planet.getSteps ();
+            displayMessage	("Planet loaded from planet.bin");
+        } else {
+            displayMessage	("Couldn't load planet.bin");
+        }
+        update ();
+    }
+}
+
+void PlanetViewer::saveTrace ()
+{
+    // The next trace starts where this one ends.
+    if(Trace::write ())
+    {
+        Trace::clear ();
+        displayMessage	("Trace saved as planet.trace.json");
+    }
 }
 
 std::istream& operator>> (std::istream &stream, qglviewer::Vec &v)
@@ -398,7 +458,8 @@ void PlanetViewer::mousePressEvent (QMouseEvent *e)
             glReadPixels(winx, winy, 0, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &winz);
             gluUnProject(winx, winy, winz, modelview, projection, viewport, &xw, &yw, &zw);
 
-            planet.closestPoint(QVector3D(xw,yw,zw));
+            if(!generationFuture.isRunning() && planet.planetCreated)
+                planet.closestPoint(QVector3D(xw,yw,zw));
             break;
         default:
             QGLViewer::mousePressEvent (e);
@@ -19,6 +19,7 @@
 
 #include "Planet.hpp"
 #include "Mesh.hpp"
+#include "ExportQueue.hpp"
 
 enum DisplayMode{WIRE=0, SOLID=1};
 
@@ -34,10 +35,18 @@ friend class PlanetDockWidget;
 
 public:
     PlanetViewer (QWidget *parent);
+
+    /**
+     * @brief Returns the queue of the exports of the planet, whose progress is shown by the window.
+     * 
+     * @return ExportQueue* 
+     */
+    ExportQueue *exports () { return &exportQueue; }
 protected:
     Planet planet;
     bool planetCreated = false;
 	QFuture<void> generationFuture;
+    ExportQueue exportQueue;
 
     unsigned int timeStep = 1;
     unsigned long int years = 0;
@@ -46,6 +55,7 @@ protected:
     QOpenGLBuffer *skyboxVBO;
     GLuint skyboxTextureID;
     QOpenGLShaderProgram *skyboxShader=nullptr;
+    std::vector<QFuture<MipChain>> skyboxFaceImages; // faces being loaded, empty once uploaded
     std::vector<std::string> skyboxFaces{
         "./res/skybox/right.jpg",
         "./res/skybox/left.jpg",
@@ -152,8 +162,19 @@ protected:
             displayMode = WIRE;
     }
 
+    /**
+     * @brief Creates the skybox cube map and starts loading its faces on the global thread pool.
+     * 
+     * @return unsigned int the texture, which shows the background color until uploadCubemap() fills it.
+     */
     unsigned int loadCubemap();
 
+    /**
+     * @brief Uploads the faces of the skybox once all of them are loaded.
+     * 
+     */
+    void uploadCubemap();
+
     /**
      * @brief Method to clear the objects in the viewer.
      * 
@@ -203,17 +224,47 @@ public slots:
 	void setPlanetElem (QString _elems);
 
     /**
-     * @brief Saves the planet in an .off file
+     * @brief Queues the export of the planet in an .off file
      * 
      */
     void savePlanetOff ();
 
     /**
-     * @brief Saves the planet in an .obj file(not functional).
+     * @brief Queues the export of the planet in an .obj file.
      * 
      */
     void savePlanetObj ();
 
+    /**
+     * @brief Queues the export of the planet in a binary .ply file.
+     * 
+     */
+    void savePlanetPly ();
+
+    /**
+     * @brief Queues the export of the planet in a binary glTF file.
+     * 
+     */
+    void savePlanetGlb ();
+
+    /**
+     * @brief Saves the planet in a binary snapshot, planet.bin.
+     * 
+     */
+    void savePlanetSnapshot ();
+
+    /**
+     * @brief Replaces the planet by the snapshot planet.bin, to resume its simulation.
+     * 
+     */
+    void loadPlanetSnapshot ();
+
+    /**
+     * @brief Writes the spans traced since the previous save in planet.trace.json, to open in chrome://tracing or Perfetto.
+     * 
+     */
+    void saveTrace ();
+
     /**
      * @brief Set the Oceanic Elevation object
      * 
@@ -1,5 +1,5 @@
 QT += opengl widgets gui xml concurrent
-QMAKE_CXXFLAGS = -O3 -std=c++20 -march=native -pedantic
+QMAKE_CXXFLAGS = -O3 -std=c++20 -march=native -ffp-contract=off -pedantic
 QMAKE_CXXFLAGS -= -O1 
 QMAKE_CXXFLAGS_DEBUG -= -O2 -O1
 QMAKE_CXXFLAGS_RELEASE -= -O2 -O1
@@ -9,27 +9,49 @@ TEMPLATE = app
 TARGET = ProceduralPlanet
 MOC_DIR = ./moc
 OBJECTS_DIR = ./obj
+# Uncomment to record the tracing spans
+# DEFINES += PLANET_TRACING
 DEPENDPATH += ./GLSL
 INCLUDEPATH += ./GLSL
 SOURCES += Main.cpp \
     Planet.cpp \
+    ExportQueue.cpp \
+    MeshExport.cpp \
+    PlanetSnapshot.cpp \
     PlanetDockWidget.cpp \
     PlanetViewer.cpp \
     Window.cpp \
-    Noise.cpp
+    Noise.cpp \
+    MipChain.cpp \
+    OneRing.cpp \
+    SphereGrid.cpp \
+    SphereTriangulation.cpp \
+    ShaderProgram.cpp \
+    StreamBuffer.cpp \
+    Trace.cpp \
+    TopologyCache.cpp
 HEADERS += \
     Planet.hpp \
     PlanetDockWidget.hpp \
     PlanetViewer.hpp \
     Plate.hpp \
     Mesh.hpp \
+    ExportQueue.hpp \
+    MeshExport.hpp \
+    MipChain.hpp \
     Window.hpp \
-    Noise.hpp
+    Noise.hpp \
+    OneRing.hpp \
+    PlanetSnapshot.hpp \
+    SphereGrid.hpp \
+    SphereTriangulation.hpp \
+    ShaderProgram.hpp \
+    StreamBuffer.hpp \
+    Trace.hpp \
+    TopologyCache.hpp
 LIBS = -lQGLViewer-qt5 \
     -lglut \
     -lGLU \
-    -lmpfr \
-    -lgmp \
     -lm \
     -ltcmalloc \
     -lpthread \
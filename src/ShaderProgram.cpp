@@ -0,0 +1,32 @@
+#include "ShaderProgram.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+QOpenGLShaderProgram *loadShaderProgram (const std::string &name)
+{
+    QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+    std::filesystem::path fs = std::filesystem::current_path ();
+    std::string path = fs.string () + "/GLSL/shaders/" + name;
+    QString  vShaderPath = QString::fromStdString(path + ".vert");
+    QString  fShaderPath = QString::fromStdString(path + ".frag");
+
+    // The cacheable shaders are only compiled by link(), if their program is not in the cache.
+    if(!program->addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,vShaderPath)) [[unlikely]]
+    {
+        std::cerr<<program->log().toStdString()<<std::endl;
+        std::cerr<<"Couldn't add VERTEX shader"<<std::endl;
+    }
+    if(!program->addCacheableShaderFromSourceFile(QOpenGLShader::Fragment,fShaderPath)) [[unlikely]]
+    {
+        std::cerr<<program->log().toStdString()<<std::endl;
+        std::cerr<<"Couldn't add FRAGMENT shader"<<std::endl;
+    }
+
+    if(!program->link()) [[unlikely]]
+    {
+        std::cerr<<program->log().toStdString()<<std::endl;
+        std::cerr<<"Error linking program "<<name<<std::endl;
+    }
+    return program;
+}
@@ -0,0 +1,17 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <QOpenGLShaderProgram>
+#include <string>
+
+/**
+ * @brief Builds the program made of the shaders GLSL/shaders/<name>.vert and GLSL/shaders/<name>.frag.
+ * The shaders are added as cacheable: Qt stores the linked program binary on disk, keyed by the
+ * sources and the driver, and only compiles them again when either changed.
+ *
+ * @param name the name of the shader files, without extension.
+ * @return QOpenGLShaderProgram* the program, whose errors are logged.
+ */
+QOpenGLShaderProgram *loadShaderProgram (const std::string &name);
+
+#endif // SHADERPROGRAM_H
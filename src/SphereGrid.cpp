@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <cmath>
+#include <climits>
+
+#include "SphereGrid.hpp"
+
+#define PI 3.14159265358979323846
+
+static double longitude (const QVector3D &p)
+{
+    double l = atan2(p.y(), p.x());
+    return l < 0 ? l + 2 * PI : l;
+}
+
+unsigned int SphereGrid::bandOf (float z) const
+{
+    const long bandCount = bandMinRadius.size();
+    long b = (long)floor((z + 1.0) * 0.5 * bandCount);
+    return (unsigned int)std::clamp(b, 0l, bandCount - 1);
+}
+
+unsigned int SphereGrid::cellOf (unsigned int band, float l) const
+{
+    const long m = bandOffsets[band + 1] - bandOffsets[band];
+    long c = (long)floor(l / (2 * PI) * m);
+    return bandOffsets[band] + (unsigned int)std::clamp(c, 0l, m - 1);
+}
+
+void SphereGrid::build (const std::vector<QVector3D> &i_points, float _cellSize)
+{
+    clear();
+    points = &i_points;
+    cellSize = _cellSize;
+
+    const unsigned int bandCount = std::max(1, (int)ceil(2.0 / cellSize));
+    const double h = 2.0 / bandCount;
+    bandMinRadius.resize(bandCount);
+    bandOffsets.resize(bandCount + 1);
+    bandOffsets[0] = 0;
+    for(unsigned int b = 0; b < bandCount; ++b)
+    {
+        double z0 = -1.0 + b * h, z1 = z0 + h;
+        double maxRadius = (z0 <= 0 && z1 >= 0) ? 1.0 : sqrt(1.0 - std::min(z0 * z0, z1 * z1));
+        bandMinRadius[b] = sqrt(std::max(0.0, 1.0 - std::max(z0 * z0, z1 * z1)));
+        unsigned int cells = std::max(1, (int)floor(2 * PI * maxRadius / cellSize));
+        bandOffsets[b + 1] = bandOffsets[b] + cells;
+    }
+
+    std::vector<unsigned int> cellIds(i_points.size());
+    std::transform(std::execution::par, i_points.begin(), i_points.end(), cellIds.begin(),
+        [this](const QVector3D &p){ return cellOf(bandOf(p.z()), longitude(p)); });
+
+    cellOffsets.assign(bandOffsets.back() + 1, 0);
+    for(unsigned int c : cellIds)
+        cellOffsets[c + 1]++;
+    std::partial_sum(cellOffsets.begin(), cellOffsets.end(), cellOffsets.begin());
+
+    std::vector<unsigned int> cursor(cellOffsets.begin(), cellOffsets.end() - 1);
+    cellPoints.resize(i_points.size());
+    for(size_t i = 0; i < cellIds.size(); ++i)
+        cellPoints[cursor[cellIds[i]]++] = i;
+}
+
+void SphereGrid::clear ()
+{
+    points = nullptr;
+    bandOffsets.clear();
+    bandMinRadius.clear();
+    cellOffsets.clear();
+    cellPoints.clear();
+}
+
+void SphereGrid::radiusSearch (const QVector3D &p, float r, std::vector<unsigned int> &o_points) const
+{
+    o_points.clear();
+    if(empty())
+        return;
+
+    const std::vector<QVector3D> &pts = *points;
+    const float r2 = r * r;
+    // The cells are selected with a small margin so that rounding never drops a point on their border.
+    const double reach = r * (1.0 + 1e-5) + 1e-6;
+    const double pRadius = sqrt(std::max(0.0, 1.0 - (double)p.z() * p.z()));
+    const double pLongitude = longitude(p);
+
+    auto scanCell = [&](unsigned int c)
+    {
+        for(unsigned int i = cellOffsets[c]; i < cellOffsets[c + 1]; ++i)
+        {
+            unsigned int id = cellPoints[i];
+            if((pts[id] - p).lengthSquared() <= r2)
+                o_points.push_back(id);
+        }
+    };
+
+    const unsigned int b0 = bandOf(p.z() - reach), b1 = bandOf(p.z() + reach);
+    for(unsigned int b = b0; b <= b1; ++b)
+    {
+        const long m = bandOffsets[b + 1] - bandOffsets[b];
+        // chord >= 2 * sqrt(r_p * r_q) * sin(delta_longitude / 2), with r_p, r_q the distances to the z axis.
+        double ring = pRadius * bandMinRadius[b];
+        double s = ring > 0 ? reach / (2 * sqrt(ring)) : 2.0;
+        long first = 0, last = m - 1;
+        if(s < 1.0)
+        {
+            double delta = 2 * asin(s);
+            first = (long)floor((pLongitude - delta) / (2 * PI) * m);
+            last = (long)floor((pLongitude + delta) / (2 * PI) * m);
+            if(last - first + 1 >= m)
+            {
+                first = 0;
+                last = m - 1;
+            }
+        }
+        for(long c = first; c <= last; ++c)
+            scanCell(bandOffsets[b] + (unsigned int)(((c % m) + m) % m));
+    }
+}
+
+void SphereGrid::kNearest (const QVector3D &p, size_t k, std::vector<unsigned int> &o_points) const
+{
+    o_points.clear();
+    if(empty() || k == 0)
+        return;
+
+    const std::vector<QVector3D> &pts = *points;
+    k = std::min(k, pts.size());
+    // Every point is within a chord distance of 2, so the loop ends with all the points at worst.
+    for(float r = cellSize; ; r *= 2)
+    {
+        radiusSearch(p, std::min(r, 2.0f), o_points);
+        if(o_points.size() >= k || r >= 2.0f)
+            break;
+    }
+
+    auto closer = [&](unsigned int a, unsigned int b){
+        float da = (pts[a] - p).lengthSquared(), db = (pts[b] - p).lengthSquared();
+        return da < db || (da == db && a < b);
+    };
+    k = std::min(k, o_points.size());
+    std::partial_sort(o_points.begin(), o_points.begin() + k, o_points.end(), closer);
+    o_points.resize(k);
+}
+
+unsigned int SphereGrid::nearest (const QVector3D &p) const
+{
+    std::vector<unsigned int> found;
+    kNearest(p, 1, found);
+    return found.empty() ? UINT_MAX : found.front();
+}
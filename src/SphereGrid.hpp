@@ -0,0 +1,73 @@
+#ifndef SPHEREGRID_H
+#define SPHEREGRID_H
+
+#include <QVector3D>
+#include <vector>
+
+/**
+ * @brief Spatial index of points lying on the unit sphere.
+ * The sphere is cut in bands of constant height along the z axis, and each band
+ * is cut in cells of constant longitude so that every cell covers roughly the same area.
+ */
+class SphereGrid
+{
+private:
+    const std::vector<QVector3D> *points = nullptr;
+    float cellSize = 0.0f;
+    std::vector<unsigned int> bandOffsets; // first cell of each band, plus the total number of cells
+    std::vector<float> bandMinRadius;      // smallest distance to the z axis inside each band
+    std::vector<unsigned int> cellOffsets; // first point of each cell in cellPoints
+    std::vector<unsigned int> cellPoints;
+
+    unsigned int bandOf (float z) const;
+    unsigned int cellOf (unsigned int band, float longitude) const;
+
+public:
+    SphereGrid(){}
+
+    /**
+     * @brief Builds the index.
+     * The points are referenced, not copied, and must outlive the grid.
+     *
+     * @param i_points unit vectors.
+     * @param _cellSize the approximate size of a cell (as a chord length).
+     */
+    void build (const std::vector<QVector3D> &i_points, float _cellSize);
+
+    /**
+     * @brief Clears the index.
+     *
+     */
+    void clear ();
+
+    /**
+     * @brief Collects the points whose chord distance to <b>p</b> is at most <b>r</b>.
+     *
+     * @param p unit vector.
+     * @param r the chord distance.
+     * @param o_points the indices of the points found, in no particular order.
+     */
+    void radiusSearch (const QVector3D &p, float r, std::vector<unsigned int> &o_points) const;
+
+    /**
+     * @brief Collects the <b>k</b> points closest to <b>p</b>.
+     * The search radius starts at the cell size and doubles until enough points are found.
+     *
+     * @param p unit vector.
+     * @param k the number of points to collect.
+     * @param o_points the indices of the points found, closest first (ties broken by index).
+     */
+    void kNearest (const QVector3D &p, size_t k, std::vector<unsigned int> &o_points) const;
+
+    /**
+     * @brief Finds the point closest to <b>p</b>.
+     *
+     * @param p unit vector.
+     * @return unsigned int the index of the point, or UINT_MAX if the grid is empty.
+     */
+    unsigned int nearest (const QVector3D &p) const;
+
+    bool empty () const { return cellPoints.empty(); }
+};
+
+#endif // SPHEREGRID_H
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <iostream>
+#include <cmath>
+
+#include "SphereTriangulation.hpp"
+#include "SphereGrid.hpp"
+
+#define PI 3.14159265358979323846
+
+/**
+ * @brief Orientation of the tetrahedron (a, b, c, d).
+ * The determinant is computed on the sorted indices so that every caller gets the same
+ * answer for the same four points, and an exact zero is counted as positive for the sorted order.
+ *
+ * @return 1 if d lies on the side pointed by (b - a) x (c - a), -1 otherwise.
+ */
+static int sortedOrient (const std::vector<QVector3D> &p, unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+{
+    unsigned int v[4] = {a, b, c, d};
+    bool odd = false;
+    auto order = [&](int i, int j){
+        if(v[i] > v[j])
+        {
+            std::swap(v[i], v[j]);
+            odd = !odd;
+        }
+    };
+    order(0, 1); order(2, 3); order(0, 2); order(1, 3); order(1, 2);
+
+    const QVector3D &o = p[v[0]];
+    double bx = (double)p[v[1]].x() - o.x(), by = (double)p[v[1]].y() - o.y(), bz = (double)p[v[1]].z() - o.z();
+    double cx = (double)p[v[2]].x() - o.x(), cy = (double)p[v[2]].y() - o.y(), cz = (double)p[v[2]].z() - o.z();
+    double dx = (double)p[v[3]].x() - o.x(), dy = (double)p[v[3]].y() - o.y(), dz = (double)p[v[3]].z() - o.z();
+    double det = bx * (cy * dz - cz * dy) - by * (cx * dz - cz * dx) + bz * (cx * dy - cy * dx);
+
+    int sign = det < 0 ? -1 : 1;
+    return odd ? -sign : sign;
+}
+
+/**
+ * @brief Orientation of the tetrahedron (a, b, c, d), consistent with sortedOrient().
+ * The determinant is first evaluated as given and only re-evaluated on the sorted indices
+ * when it is too close to zero for its sign to be trusted.
+ *
+ * @return 1 if d lies on the side pointed by (b - a) x (c - a), -1 otherwise.
+ */
+static int orient (const std::vector<QVector3D> &p, unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+{
+    const QVector3D &o = p[a];
+    double bx = (double)p[b].x() - o.x(), by = (double)p[b].y() - o.y(), bz = (double)p[b].z() - o.z();
+    double cx = (double)p[c].x() - o.x(), cy = (double)p[c].y() - o.y(), cz = (double)p[c].z() - o.z();
+    double dx = (double)p[d].x() - o.x(), dy = (double)p[d].y() - o.y(), dz = (double)p[d].z() - o.z();
+    double det = bx * (cy * dz - cz * dy) - by * (cx * dz - cz * dx) + bz * (cx * dy - cy * dx);
+
+    // Both evaluations are off by less than 5e-14 * m^3, m being the largest coordinate difference.
+    double m = std::max({fabs(bx), fabs(by), fabs(bz), fabs(cx), fabs(cy), fabs(cz), fabs(dx), fabs(dy), fabs(dz)});
+    if(fabs(det) > 1e-13 * m * m * m) [[likely]]
+        return det < 0 ? -1 : 1;
+    return sortedOrient(p, a, b, c, d);
+}
+
+/**
+ * @brief Radius of the circle going through a, b and c.
+ */
+static double circumradius (const QVector3D &a, const QVector3D &b, const QVector3D &c)
+{
+    QVector3D ab = b - a, ac = c - a, bc = c - b;
+    double area2 = QVector3D::crossProduct(ab, ac).length();
+    if(area2 <= 0)
+        return std::numeric_limits<double>::max();
+    return (double)ab.length() * ac.length() * bc.length() / (2 * area2);
+}
+
+/**
+ * @brief Wraps the hull facets around the point i.
+ *
+ * @param i the center point.
+ * @param candidates the points close to i, without i.
+ * @param o_ring the neighbours of i, counter-clockwise when seen from outside.
+ * @return true if the ring closed.
+ */
+static bool wrap (const std::vector<QVector3D> &p, unsigned int i, const std::vector<unsigned int> &candidates,
+    std::vector<unsigned int> &o_ring)
+{
+    o_ring.clear();
+    if(candidates.size() < 3)
+        return false;
+
+    // The nearest point is always a Delaunay neighbour.
+    unsigned int first = *std::min_element(candidates.begin(), candidates.end(),
+        [&](unsigned int a, unsigned int b){ return (p[a] - p[i]).lengthSquared() < (p[b] - p[i]).lengthSquared(); });
+    unsigned int j = first;
+    o_ring.push_back(first);
+
+    for(size_t step = 0; step < candidates.size(); ++step)
+    {
+        unsigned int k = j;
+        for(unsigned int m : candidates)
+        {
+            if(m == j)
+                continue;
+            if(k == j || orient(p, i, j, k, m) > 0)
+                k = m;
+        }
+        if(k == first)
+            return true;
+        if(std::find(o_ring.begin(), o_ring.end(), k) != o_ring.end())
+            return false;
+        o_ring.push_back(k);
+        j = k;
+    }
+    return false;
+}
+
+void triangulateSphere (const std::vector<QVector3D> &i_points, std::vector<unsigned int> &o_triangles)
+{
+    o_triangles.clear();
+    const size_t n = i_points.size();
+    if(n < 4)
+        return;
+
+    // Delaunay edges of a well spread point set are about one mean spacing long:
+    // 2.5 spacings gathers ~20 candidates and is widened where it is not enough.
+    const float spacing = sqrt(4 * PI / n);
+    const float initialRadius = std::min(2.5f * spacing, 2.0f);
+    SphereGrid grid;
+    grid.build(i_points, initialRadius);
+
+    const size_t blockSize = 1024;
+    std::vector<size_t> blocks((n + blockSize - 1) / blockSize);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    std::vector<std::vector<unsigned int>> blockTriangles(blocks.size());
+    std::vector<unsigned int> blockFailures(blocks.size(), 0);
+
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block)
+    {
+        std::vector<unsigned int> candidates, ring;
+        std::vector<unsigned int> &triangles = blockTriangles[block];
+        triangles.reserve(blockSize * 6);
+
+        for(size_t i = block * blockSize; i < std::min(n, (block + 1) * blockSize); ++i)
+        {
+            bool closed = false;
+            for(float radius = initialRadius; !closed; radius *= 2)
+            {
+                grid.radiusSearch(i_points[i], radius, candidates);
+                candidates.erase(std::remove(candidates.begin(), candidates.end(), (unsigned int)i), candidates.end());
+                closed = wrap(i_points, i, candidates, ring);
+
+                // A point inside the circle of a facet is closer to i than the circle diameter:
+                // the facets are exact if their circles fit in the search radius.
+                for(size_t t = 0; closed && radius < 2.0f && t < ring.size(); ++t)
+                {
+                    const QVector3D &a = i_points[ring[t]], &b = i_points[ring[(t + 1) % ring.size()]];
+                    if(2 * circumradius(i_points[i], a, b) > radius)
+                        closed = false;
+                }
+                if(radius >= 2.0f)
+                    break;
+            }
+
+            if(!closed) [[unlikely]]
+            {
+                blockFailures[block]++;
+                continue;
+            }
+
+            for(size_t t = 0; t < ring.size(); ++t)
+            {
+                unsigned int a = ring[t], b = ring[(t + 1) % ring.size()];
+                if(i < a && i < b)
+                {
+                    triangles.push_back(i);
+                    triangles.push_back(a);
+                    triangles.push_back(b);
+                }
+            }
+        }
+    });
+
+    size_t total = 0;
+    for(const std::vector<unsigned int> &triangles : blockTriangles)
+        total += triangles.size();
+    o_triangles.reserve(total);
+    for(const std::vector<unsigned int> &triangles : blockTriangles)
+        o_triangles.insert(o_triangles.end(), triangles.begin(), triangles.end());
+
+    unsigned int failures = std::accumulate(blockFailures.begin(), blockFailures.end(), 0u);
+    if(failures != 0 || o_triangles.size() != 3 * (2 * n - 4)) [[unlikely]]
+    {
+        std::cerr << "Sphere triangulation: " << failures << " point(s) failed, "
+            << o_triangles.size() / 3 << " facets instead of " << 2 * n - 4 << std::endl;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef SPHERETRIANGULATION_H
+#define SPHERETRIANGULATION_H
+
+#include <QVector3D>
+#include <vector>
+
+/**
+ * @brief Computes the Delaunay triangulation of points lying on the unit sphere.
+ * The triangulation is the convex hull of the points: each point gathers its neighbours
+ * with a SphereGrid and wraps the hull facets around itself, which only involves a few
+ * dozen candidates per point and runs in parallel. The facets are emitted by their
+ * smallest vertex and every orientation test is evaluated on its sorted vertices, so
+ * that the points sharing a facet always agree on it, even for co-circular points.
+ *
+ * @param i_points unit vectors, without duplicates.
+ * @param o_triangles three indices per triangle, counter-clockwise when seen from outside the sphere.
+ */
+void triangulateSphere (const std::vector<QVector3D> &i_points, std::vector<unsigned int> &o_triangles);
+
+#endif // SPHERETRIANGULATION_H
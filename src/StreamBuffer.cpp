@@ -0,0 +1,112 @@
+#include <cstring>
+#include <iostream>
+
+#include "StreamBuffer.hpp"
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void (*BufferStorage) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+bool StreamBuffer::isSupported ()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    return context && context->hasExtension("GL_ARB_buffer_storage") && context->getProcAddress("glBufferStorage");
+}
+
+bool StreamBuffer::create (const void *data, size_t _regionBytes)
+{
+    destroy();
+    context = QOpenGLContext::currentContext();
+    if(!isSupported() || _regionBytes == 0)
+        return false;
+
+    BufferStorage glBufferStorage = reinterpret_cast<BufferStorage>(context->getProcAddress("glBufferStorage"));
+    gl = context->extraFunctions();
+    regionBytes = _regionBytes;
+
+    // Coherent: the writes through the mapping are seen by the next draw calls without any flush.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gl->glGenBuffers(1, &buffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, regionCount * regionBytes, nullptr, flags);
+    mapping = static_cast<char *>(gl->glMapBufferRange(GL_ARRAY_BUFFER, 0, regionCount * regionBytes, flags));
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if(!mapping) [[unlikely]]
+    {
+        std::cerr << "Could not map the stream buffer" << std::endl;
+        destroy();
+        return false;
+    }
+
+    for(unsigned int r = 0; r < regionCount; ++r)
+        memcpy(mapping + r * regionBytes, data, regionBytes);
+    current = 0;
+    return true;
+}
+
+void StreamBuffer::destroy ()
+{
+    if(!buffer)
+        return;
+    if(QOpenGLContext::currentContext() == context) [[likely]]
+    {
+        for(GLsync sync : fences)
+        {
+            if(sync)
+                gl->glDeleteSync(sync);
+        }
+        if(mapping)
+        {
+            gl->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            gl->glUnmapBuffer(GL_ARRAY_BUFFER);
+            gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        gl->glDeleteBuffers(1, &buffer);
+    }
+    else
+        std::cerr << "The stream buffer is destroyed without its context" << std::endl;
+    for(GLsync &sync : fences)
+        sync = nullptr;
+    buffer = 0;
+    mapping = nullptr;
+    regionBytes = 0;
+}
+
+void StreamBuffer::wait (unsigned int region)
+{
+    GLsync &sync = fences[region];
+    if(!sync)
+        return;
+    // The first wait flushes the fence, so that it is signaled even if nothing else is submitted.
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while(true)
+    {
+        GLenum status = gl->glClientWaitSync(sync, flags, 1000000000);
+        if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+            break;
+        flags = 0;
+    }
+    gl->glDeleteSync(sync);
+    sync = nullptr;
+}
+
+char *StreamBuffer::nextRegion ()
+{
+    current = (current + 1) % regionCount;
+    wait(current);
+    return mapping + current * regionBytes;
+}
+
+void StreamBuffer::fence ()
+{
+    if(!buffer)
+        return;
+    if(fences[current])
+        gl->glDeleteSync(fences[current]);
+    fences[current] = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
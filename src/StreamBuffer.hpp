@@ -0,0 +1,78 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+/**
+ * @brief Vertex buffer made of several regions of the same size, persistently mapped with ARB_buffer_storage.
+ * The CPU writes the next region through the mapping while the GPU still draws from the previous ones,
+ * each region being protected by a fence until the draw calls reading it are done.
+ */
+class StreamBuffer
+{
+public:
+    static const unsigned int regionCount = 3;
+
+private:
+    QOpenGLContext *context = nullptr; // the one the buffer was created in
+    QOpenGLExtraFunctions *gl = nullptr;
+    GLuint buffer = 0;
+    size_t regionBytes = 0;
+    char *mapping = nullptr;
+    GLsync fences[regionCount] = {};
+    unsigned int current = 0;
+
+    /**
+     * @brief Waits until the GPU has executed the draw calls issued before the fence of a region.
+     * 
+     * @param region 
+     */
+    void wait (unsigned int region);
+
+public:
+    StreamBuffer(){}
+    ~StreamBuffer(){ destroy(); }
+
+    /**
+     * @brief Tells whether the current context can create persistently mapped buffers.
+     * 
+     * @return true if ARB_buffer_storage is available.
+     */
+    static bool isSupported ();
+
+    /**
+     * @brief Creates the buffer in the current context and fills every region with the same data.
+     * 
+     * @param data the initial content of the regions.
+     * @param _regionBytes the size of a region in bytes.
+     * @return true if the buffer could be created and mapped.
+     */
+    bool create (const void *data, size_t _regionBytes);
+
+    /**
+     * @brief Unmaps and deletes the buffer, which needs its context to be current.
+     * Otherwise the buffer is only forgotten, and released with its context.
+     */
+    void destroy ();
+
+    bool isCreated () const { return buffer != 0; }
+    GLuint bufferId () const { return buffer; }
+    unsigned int region () const { return current; }
+    size_t regionOffset () const { return current * regionBytes; }
+
+    /**
+     * @brief Moves to the next region, waiting for the GPU if it may still read it.
+     * 
+     * @return char* the mapping of the region, to be written before it is drawn.
+     */
+    char *nextRegion ();
+
+    /**
+     * @brief Fences the current region, after the draw calls reading it.
+     * 
+     */
+    void fence ();
+};
+
+#endif // STREAMBUFFER_H
@@ -0,0 +1,159 @@
+#include "TopologyCache.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+const quint32 TopologyCache::version = 1;
+const qint64 TopologyCache::maxBytes = qint64(1) << 30;
+
+namespace
+{
+    const char magic[4] = {'T', 'O', 'P', 'O'};
+    const quint32 byteOrderMark = 0x01020304;
+
+    QString &cacheDirectory ()
+    {
+        static QString directory = qEnvironmentVariableIsSet("PLANET_TOPOLOGY_CACHE")
+            ? qEnvironmentVariable("PLANET_TOPOLOGY_CACHE")
+            : QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/ProceduralPlanet/topology";
+        return directory;
+    }
+
+    enum Section {INDICES, RING_OFFSETS, RING_NEIGHBOURS, SECTION_COUNT};
+
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        quint32 byteOrderMark;
+        quint32 padding;
+        quint64 vertexCount;
+        quint64 offsets[SECTION_COUNT]; // from the start of the file, aligned on 16 bytes
+        quint64 counts[SECTION_COUNT];  // of unsigned int
+    };
+}
+
+QString TopologyCache::directory ()
+{
+    return cacheDirectory();
+}
+
+void TopologyCache::setDirectory (const QString &_directory)
+{
+    cacheDirectory() = _directory;
+}
+
+QString TopologyCache::path (size_t vertexCount)
+{
+    return directory() + "/sphere_" + QString::number(qulonglong(vertexCount)) + "_v" + QString::number(version) + ".topo";
+}
+
+TopologyCache TopologyCache::load (size_t vertexCount)
+{
+    TopologyCache result;
+    if(directory().isEmpty())
+        return result;
+    std::shared_ptr<QFile> cache = std::make_shared<QFile>(path(vertexCount));
+    if(!cache->open(QIODevice::ReadOnly))
+        return result;
+    const quint64 size = cache->size();
+    const uchar *data = size >= sizeof(Header) ? cache->map(0, size) : nullptr;
+    if(!data)
+        return result;
+
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+    if(memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version
+        || header.byteOrderMark != byteOrderMark || header.vertexCount != vertexCount
+        || header.counts[RING_OFFSETS] != vertexCount + 1 || header.counts[INDICES] % 3 != 0)
+        return result;
+    for(int s = 0; s < SECTION_COUNT; ++s)
+    {
+        if(header.offsets[s] % 16 != 0 || header.offsets[s] > size
+            || header.counts[s] > (size - header.offsets[s]) / sizeof(unsigned int))
+            return result;
+    }
+    auto section = [&](Section s){
+        return std::span<const unsigned int>(reinterpret_cast<const unsigned int *>(data + header.offsets[s]), header.counts[s]);
+    };
+    // The content is checked as well, in one pass over the file: a corrupted index would be read out of
+    // the arrays of the planet.
+    const std::span<const unsigned int> ringOffsets = section(RING_OFFSETS);
+    auto outOfRange = [&](unsigned int i){ return i >= vertexCount; };
+    if(ringOffsets.front() != 0 || ringOffsets.back() != header.counts[RING_NEIGHBOURS]
+        || std::adjacent_find(ringOffsets.begin(), ringOffsets.end(), std::greater<unsigned int>()) != ringOffsets.end()
+        || std::any_of(section(INDICES).begin(), section(INDICES).end(), outOfRange)
+        || std::any_of(section(RING_NEIGHBOURS).begin(), section(RING_NEIGHBOURS).end(), outOfRange))
+    {
+        std::cerr << "Ignoring the corrupted topology cache " << path(vertexCount).toStdString() << std::endl;
+        return result;
+    }
+
+    result.indices = section(INDICES);
+    result.offsets = section(RING_OFFSETS);
+    result.neighbours = section(RING_NEIGHBOURS);
+    result.file = cache;
+    return result;
+}
+
+bool TopologyCache::save (size_t vertexCount, std::span<const unsigned int> triangles, const OneRing &oneRing)
+{
+    if(directory().isEmpty())
+        return false;
+    const std::span<const unsigned int> data[SECTION_COUNT] = {triangles, oneRing.rowOffsets(), oneRing.allNeighbours()};
+
+    Header header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.vertexCount = vertexCount;
+    quint64 offset = sizeof(Header);
+    for(int s = 0; s < SECTION_COUNT; ++s)
+    {
+        header.offsets[s] = (offset + 15) & ~quint64(15);
+        header.counts[s] = data[s].size();
+        offset = header.offsets[s] + data[s].size_bytes();
+    }
+
+    const QString cachePath = path(vertexCount);
+    QSaveFile cache(cachePath);
+    bool written = QDir().mkpath(directory()) && cache.open(QIODevice::WriteOnly)
+        && cache.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header));
+    offset = sizeof(Header);
+    const char padding[16] = {};
+    for(int s = 0; s < SECTION_COUNT && written; ++s)
+    {
+        written = cache.write(padding, header.offsets[s] - offset) == qint64(header.offsets[s] - offset)
+            && cache.write(reinterpret_cast<const char *>(data[s].data()), data[s].size_bytes()) == qint64(data[s].size_bytes());
+        offset = header.offsets[s] + data[s].size_bytes();
+    }
+    if(!written || !cache.commit())
+    {
+        std::cerr << "Couldn't write the topology cache " << cachePath.toStdString() << std::endl;
+        return false;
+    }
+    evict(cachePath);
+    return true;
+}
+
+void TopologyCache::evict (const QString &kept)
+{
+    // A process which has mapped a removed file keeps reading it until it unmaps it.
+    const QFileInfoList files = QDir(directory()).entryInfoList({"*.topo"}, QDir::Files, QDir::Time);
+    qint64 bytes = 0;
+    for(const QFileInfo &file : files)
+    {
+        bytes += file.size();
+        if(bytes > maxBytes && file.absoluteFilePath() != QFileInfo(kept).absoluteFilePath())
+        {
+            QFile::remove(file.absoluteFilePath());
+            bytes -= file.size();
+        }
+    }
+}
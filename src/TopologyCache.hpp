@@ -0,0 +1,105 @@
+#ifndef TOPOLOGYCACHE_H
+#define TOPOLOGYCACHE_H
+
+#include <QFile>
+#include <QtGlobal>
+#include <span>
+#include <memory>
+
+#include "OneRing.hpp"
+
+/**
+ * @brief Triangulation and one-ring of the Fibonacci sphere of a given number of points, kept in a
+ * cache file. The file is mapped read-only, so that the processes generating planets of the same size
+ * on a machine share its pages and only read it from the disk once.
+ * The version must change with the sampling of the sphere, its triangulation or the one-ring.
+ * The files take maxBytes at most: the least recently written ones are removed beyond it.
+ */
+class TopologyCache
+{
+private:
+    std::shared_ptr<QFile> file; // cache file whose mapping holds the arrays
+    std::span<const unsigned int> indices, offsets, neighbours;
+
+    /**
+     * @brief Returns the path of the cache file of a number of points.
+     *
+     * @param vertexCount
+     * @return QString
+     */
+    static QString path (size_t vertexCount);
+
+    /**
+     * @brief Removes the least recently written cache files until they take maxBytes at most.
+     *
+     * @param kept the file just written, which is never removed.
+     */
+    static void evict (const QString &kept);
+
+public:
+    static const quint32 version;
+
+    /**
+     * @brief Bytes that the cache files may take together, 260 MB being the size of 5M points.
+     */
+    static const qint64 maxBytes;
+
+    /**
+     * @brief Returns the directory of the cache files: the PLANET_TOPOLOGY_CACHE environment variable
+     * if it is set, the topology directory of the user cache (~/.cache/ProceduralPlanet) otherwise.
+     * The cache is disabled when the directory is empty.
+     *
+     * @return QString
+     */
+    static QString directory ();
+
+    /**
+     * @brief Replaces the directory of the cache files, an empty one disabling the cache.
+     * It must be set before the planets are generated.
+     *
+     * @param _directory
+     */
+    static void setDirectory (const QString &_directory);
+
+    /**
+     * @brief Maps the cache file of a number of points.
+     *
+     * @param vertexCount
+     * @return TopologyCache a null cache if there is no valid file or the cache is disabled.
+     */
+    static TopologyCache load (size_t vertexCount);
+
+    /**
+     * @brief Writes the cache file of a number of points, replacing the previous one at once so that
+     * other processes never map a partial file.
+     *
+     * @param vertexCount
+     * @param triangles three vertex indices per triangle.
+     * @param oneRing the adjacency of the triangles.
+     * @return true if the file was written, which it is not when the cache is disabled.
+     */
+    static bool save (size_t vertexCount, std::span<const unsigned int> triangles, const OneRing &oneRing);
+
+    bool isNull () const { return !file; }
+
+    /**
+     * @brief Returns the three vertex indices of each triangle, read from the mapping.
+     *
+     * @return std::span<const unsigned int>
+     */
+    std::span<const unsigned int> triangles () const { return indices; }
+
+    /**
+     * @brief Returns the adjacency of the triangles, whose rows are read in place from the mapping.
+     *
+     * @return OneRing
+     */
+    OneRing oneRing () const
+    {
+        OneRing ring;
+        ring.share(offsets, neighbours, file);
+        return ring;
+    }
+};
+
+#endif // TOPOLOGYCACHE_H
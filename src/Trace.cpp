@@ -0,0 +1,151 @@
+#include "Trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        long long begin, duration; // in ns, from the start of the process
+    };
+
+    /**
+     * @brief Spans of a thread. Only the writer of the trace contends for its mutex.
+     * The buffer is a ring of maxEvents spans, which keeps the latest ones while the viewer simulates.
+     */
+    struct ThreadBuffer
+    {
+        static const size_t maxEvents = 1 << 20;
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t oldest = 0; // index of the oldest span once the ring is full
+        unsigned int id;
+
+        void push (const Event &event)
+        {
+            if(events.size() < maxEvents)
+                events.push_back(event);
+            else
+            {
+                events[oldest] = event;
+                oldest = (oldest + 1) % maxEvents;
+            }
+        }
+
+        std::vector<Event> ordered () const
+        {
+            std::vector<Event> copy(events.begin() + oldest, events.end());
+            copy.insert(copy.end(), events.begin(), events.begin() + oldest);
+            return copy;
+        }
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; // kept after their thread exits
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    Registry &registry ()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    ThreadBuffer &threadBuffer ()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if(!buffer) [[unlikely]]
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = r.buffers.back().get();
+            buffer->id = r.buffers.size();
+            buffer->events.reserve(1024);
+        }
+        return *buffer;
+    }
+
+    void writeString (std::ostream &o_stream, const char *s)
+    {
+        o_stream << '"';
+        for(; *s; ++s)
+        {
+            if(*s == '"' || *s == '\\')
+                o_stream << '\\';
+            o_stream << *s;
+        }
+        o_stream << '"';
+    }
+}
+
+Trace::Span::~Span ()
+{
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point epoch = registry().epoch;
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.push({name, std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()});
+}
+
+bool Trace::write (const std::string &filename)
+{
+    if(!enabled())
+        std::cerr << "Tracing is disabled: build with PLANET_TRACING to record the spans" << std::endl;
+
+    // The timestamps are in µs, down to the ns.
+    std::ofstream ostream(filename);
+    ostream << std::fixed << std::setprecision(3);
+    ostream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    Registry &r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    for(const std::unique_ptr<ThreadBuffer> &buffer : r.buffers)
+    {
+        // The events are copied so that the thread only waits for the copy.
+        std::vector<Event> events;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            events = buffer->ordered();
+        }
+        for(const Event &event : events)
+        {
+            ostream << (first ? "\n" : ",\n") << "{\"name\":";
+            writeString(ostream, event.name);
+            ostream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << event.begin * 1e-3 << ",\"dur\":" << event.duration * 1e-3 << '}';
+            first = false;
+        }
+    }
+    ostream << "\n]}" << std::endl;
+    ostream.close();
+
+    if(!ostream) [[unlikely]]
+    {
+        std::cerr << "Couldn't write the trace " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Wrote the trace " << filename << std::endl;
+    return true;
+}
+
+void Trace::clear ()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    for(const std::unique_ptr<ThreadBuffer> &buffer : r.buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->events.clear();
+        buffer->oldest = 0;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Scoped spans recorded in per-thread buffers and written as a Chrome trace, which
+ * chrome://tracing and Perfetto open. The spans are only recorded when PLANET_TRACING is defined:
+ * otherwise TRACE_SPAN compiles to nothing.
+ */
+namespace Trace
+{
+    /**
+     * @brief Records the time between its construction and its destruction in the buffer of its thread.
+     */
+    class Span
+    {
+    private:
+        const char *name;
+        std::chrono::steady_clock::time_point begin;
+
+    public:
+        /**
+         * @brief Starts a span.
+         *
+         * @param _name a string literal, which is only read when the trace is written.
+         */
+        explicit Span (const char *_name) : name(_name), begin(std::chrono::steady_clock::now()) {}
+        ~Span ();
+
+        Span (const Span &) = delete;
+        Span &operator= (const Span &) = delete;
+    };
+
+    /**
+     * @brief Tells whether the spans are recorded.
+     *
+     * @return true if PLANET_TRACING was defined.
+     */
+    constexpr bool enabled ()
+    {
+#ifdef PLANET_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Writes the spans recorded so far by every thread as a Chrome JSON trace.
+     * A thread keeps its latest 2^20 spans, the older ones being dropped.
+     * The threads can keep recording while the trace is written.
+     *
+     * @param filename
+     * @return true if the file was written.
+     */
+    bool write (const std::string &filename = "planet.trace.json");
+
+    /**
+     * @brief Forgets the spans recorded so far.
+     */
+    void clear ();
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef PLANET_TRACING
+#define TRACE_SPAN(name) const Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) static_cast<void>(0)
+#endif
+
+#endif // TRACE_H
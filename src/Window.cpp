@@ -1,5 +1,6 @@
 #include "Window.hpp"
 #include <QFileDialog>
+#include "Trace.hpp"
 Window::Window ()
 {
 	if (this->objectName ().isEmpty ())
@@ -16,6 +17,11 @@ Window::Window ()
 	/**Actions**/
 	QAction *actionSaveOFF = new QAction ("Save Planet as .off", this);
 	QAction *actionSaveOBJ = new QAction ("Save Planet as .obj", this);
+	QAction *actionSavePLY = new QAction ("Save Planet as .ply", this);
+	QAction *actionSaveGLB = new QAction ("Save Planet as .glb", this);
+	QAction *actionSaveSnapshot = new QAction ("Save Planet snapshot", this);
+	QAction *actionLoadSnapshot = new QAction ("Load Planet snapshot", this);
+	QAction *actionSaveTrace = new QAction ("Save trace", this);
 	QAction *actionHelp = new QAction ("Help", this);
 
 
@@ -25,11 +31,22 @@ Window::Window ()
 
 	menuFile->addAction (actionSaveOFF);
 	menuFile->addAction (actionSaveOBJ);
+	menuFile->addAction (actionSavePLY);
+	menuFile->addAction (actionSaveGLB);
+	menuFile->addAction (actionSaveSnapshot);
+	menuFile->addAction (actionLoadSnapshot);
+	if (Trace::enabled ())
+		menuFile->addAction (actionSaveTrace);
 
 	menuAbout->addAction (actionHelp);
 
 	connect (actionSaveOFF, SIGNAL(triggered()), viewer, SLOT(savePlanetOff()));
 	connect (actionSaveOBJ, SIGNAL(triggered()), viewer, SLOT(savePlanetObj()));
+	connect (actionSavePLY, SIGNAL(triggered()), viewer, SLOT(savePlanetPly()));
+	connect (actionSaveGLB, SIGNAL(triggered()), viewer, SLOT(savePlanetGlb()));
+	connect (actionSaveSnapshot, SIGNAL(triggered()), viewer, SLOT(savePlanetSnapshot()));
+	connect (actionLoadSnapshot, SIGNAL(triggered()), viewer, SLOT(loadPlanetSnapshot()));
+	connect (actionSaveTrace, SIGNAL(triggered()), viewer, SLOT(saveTrace()));
 
 	connect (actionHelp, SIGNAL(triggered()), viewer, SLOT(help()));
 
@@ -54,5 +71,12 @@ Window::Window ()
 
 	this->setStatusBar (statusbar);
 
+	connect (viewer->exports (), &ExportQueue::progress, statusbar, [this](const QString &filename, int percent, int pending){
+		statusbar->showMessage (QString ("Exporting %1: %2% (%3 more queued)").arg (filename).arg (percent).arg (pending - 1));
+	});
+	connect (viewer->exports (), &ExportQueue::finished, statusbar, [this](const QString &filename, bool success){
+		statusbar->showMessage ((success ? "Planet saved as " : "Couldn't write ") + filename, 5000);
+	});
+
 	this->setWindowTitle ("Planet Generator");
 }
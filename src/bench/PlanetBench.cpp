@@ -0,0 +1,293 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <tbb/global_control.h>
+
+#include "Planet.hpp"
+#include "MeshExport.hpp"
+#include "TopologyCache.hpp"
+
+/**
+ * @brief Times the stages of the generation one at a time on a planet of a given size.
+ * Every stage runs on the state left by the previous ones, which are still run once untimed when
+ * they are not selected. The seed is fixed, so that two runs time the same work.
+ */
+class PlanetBench
+{
+public:
+    struct Result
+    {
+        std::string stage;
+        size_t elems;
+        size_t items;          // vertices processed by a run, or queries for closestPoint
+        const char *unit;
+        std::vector<double> seconds;
+        long long peakBytes;   // high-water mark of the resident memory during the stage, -1 if unknown
+        bool processWide;      // whether the mark could not be reset and is the one of the whole process
+    };
+
+    PlanetBench (size_t _elems, unsigned int plates, quint64 seed, int _repeats, const std::set<std::string> &_stages)
+        : elems(_elems), repeats(_repeats), stages(_stages)
+    {
+        planet.setElems(elems);
+        planet.setPlateNumber(plates);
+        planet.setSeed(seed);
+    }
+
+    /**
+     * @brief Runs every stage and returns the timings of the selected ones.
+     *
+     * @return std::vector<Result>
+     */
+    std::vector<Result> run ()
+    {
+        const size_t queries = 1024;
+        std::vector<QVector3D> points(queries);
+        QRandomGenerator prng(elems);
+        for(QVector3D &point : points)
+        {
+            point = QVector3D(prng.bounded(2.0) - 1.0, prng.bounded(2.0) - 1.0, prng.bounded(2.0) - 1.0).normalized();
+            point *= planet.getRadius() * (1.0 + prng.bounded(0.002));
+        }
+        const std::filesystem::path directory = std::filesystem::temp_directory_path();
+        auto exportStage = [&](const std::string &stage, const std::string &extension, const std::function<bool(const MeshView &, const std::string &)> &write){
+            const std::string filename = (directory / ("planet_bench" + extension)).string();
+            measure(stage, elems, "vertices", {}, [&]{ write(MeshView(planet.mesh), filename); });
+            std::filesystem::remove(filename);
+        };
+
+        // The stages of Planet::initPlanet(), with the one-ring built apart from the segmentation.
+        measure("makeSphere", elems, "vertices", {}, [&]{ planet.makeSphere(); });
+        measure("triangulate", elems, "vertices", {}, [&]{ planet.triangulate(); });
+        measure("buildGrid", elems, "vertices", {}, [&]{ planet.buildGrid(); });
+        measure("one_ring", elems, "vertices", {}, [&]{ planet.one_ring.build(planet.mesh.indices, planet.mesh.vertexCount()); });
+        measure("saveTopology", elems, "vertices", {}, [&]{ TopologyCache::save(elems, planet.mesh.indices, planet.one_ring); });
+        measure("loadTopology", elems, "vertices", {}, [&]{ planet.loadTopology(); });
+        planet.makeOcean();
+        measure("makePlates", elems, "vertices", [&]{ planet.seedStream = 0; }, [&]{ planet.makePlates(); });
+        measure("initElevations", elems, "vertices", [&]{ planet.resetHeights(); planet.seedStream = 1; }, [&]{ planet.initElevations(); });
+        planet.planetCreated = true;
+
+        // Every repeat moves the plates of the same planet, the one left by initElevations.
+        const std::vector<QVector3D> initialPositions = planet.mesh.positions;
+        const std::vector<float> initialElevations = planet.mesh.elevations;
+        measure("move", elems, "vertices", [&]{
+            planet.mesh.positions = initialPositions;
+            planet.mesh.elevations = initialElevations;
+        }, [&]{ planet.move(); });
+        measure("closestPoint", queries, "queries", {}, [&]{
+            for(const QVector3D &point : points)
+                planet.closestPoint(point);
+        });
+
+        exportStage("exportOBJ", ".obj", [](const MeshView &mesh, const std::string &filename){ return exportOBJ(mesh, filename); });
+        exportStage("exportOFF", ".off", [](const MeshView &mesh, const std::string &filename){ return exportOFF(mesh, filename); });
+        exportStage("exportPLY", ".ply", [](const MeshView &mesh, const std::string &filename){ return exportPLY(mesh, filename); });
+        exportStage("exportGLB", ".glb", [](const MeshView &mesh, const std::string &filename){ return exportGLB(mesh, filename); });
+        return results;
+    }
+
+private:
+    Planet planet;
+    size_t elems;
+    int repeats;
+    std::set<std::string> stages;
+    std::vector<Result> results;
+
+    /**
+     * @brief Resets the high-water mark of the resident memory, which Linux allows since 4.0.
+     *
+     * @return true if the mark was reset.
+     */
+    static bool resetPeakMemory ()
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+        clearRefs.close();
+        return bool(clearRefs);
+    }
+
+    /**
+     * @brief Returns the high-water mark of the resident memory, since the last reset if there was one.
+     *
+     * @return long long in bytes.
+     */
+    static long long peakMemory ()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while(std::getline(status, line))
+        {
+            if(line.rfind("VmHWM:", 0) == 0)
+                return std::stoll(line.substr(6)) * 1024;
+        }
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            return -1;
+        return usage.ru_maxrss * 1024ll;
+    }
+
+    /**
+     * @brief Times the repeats of a stage, or runs it once if it is not selected.
+     *
+     * @param stage
+     * @param items the number of items processed by a run of the stage.
+     * @param unit
+     * @param setup run untimed before every repeat.
+     * @param body
+     */
+    void measure (const std::string &stage, size_t items, const char *unit, const std::function<void()> &setup, const std::function<void()> &body)
+    {
+        if(!stages.empty() && !stages.count(stage))
+        {
+            if(setup)
+                setup();
+            body();
+            return;
+        }
+
+        Result result{stage, elems, items, unit, {}, -1, !resetPeakMemory()};
+        for(int r = 0; r < repeats; ++r)
+        {
+            if(setup)
+                setup();
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            body();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            result.seconds.push_back(elapsed.count());
+        }
+        result.peakBytes = peakMemory();
+        std::clog << stage << " " << elems << ": " << *std::min_element(result.seconds.begin(), result.seconds.end()) << "s" << std::endl;
+        results.push_back(result);
+    }
+};
+
+/**
+ * @brief Returns the value of a sorted sample at a quantile, with the nearest rank method.
+ *
+ * @param sorted
+ * @param q
+ * @return double
+ */
+static double quantile (const std::vector<double> &sorted, double q)
+{
+    const size_t rank = std::max<size_t>(1, size_t(std::ceil(q * sorted.size())));
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+/**
+ * @brief Writes the results as a JSON document.
+ *
+ * @param o_stream
+ * @param results
+ * @param seed
+ * @param repeats
+ */
+static void writeJson (std::ostream &o_stream, const std::vector<PlanetBench::Result> &results, quint64 seed, int repeats)
+{
+    o_stream.precision(9);
+    o_stream << "{\n  \"seed\": " << seed << ",\n  \"repeats\": " << repeats
+        << ",\n  \"threads\": " << tbb::global_control::active_value(tbb::global_control::max_allowed_parallelism)
+        << ",\n  \"results\": [";
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const PlanetBench::Result &result = results[i];
+        std::vector<double> sorted = result.seconds;
+        std::sort(sorted.begin(), sorted.end());
+        const double median = quantile(sorted, 0.5), p95 = quantile(sorted, 0.95);
+        o_stream << (i ? "," : "") << "\n    {\"stage\": \"" << result.stage << "\", \"elems\": " << result.elems
+            << ", \"items\": " << result.items << ", \"unit\": \"" << result.unit << "\""
+            << ", \"median_s\": " << median << ", \"p95_s\": " << p95
+            << ", \"throughput_per_s\": " << (median > 0 ? result.items / median : 0.0)
+            << ", \"peak_rss_bytes\": " << result.peakBytes
+            << ", \"peak_rss_process_wide\": " << (result.processWide ? "true" : "false") << "}";
+    }
+    o_stream << "\n  ]\n}" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+    QCoreApplication a (argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription ("Times the stages of the planet generation");
+    parser.addHelpOption ();
+
+    QCommandLineOption sizesOption ("sizes", "Comma separated numbers of points.", "N,...", "10000,100000,1000000,5000000");
+    QCommandLineOption platesOption ("plates", "Number of tectonic plates.", "K", "17");
+    QCommandLineOption seedOption ("seed", "Seed of the random generators.", "S", "42");
+    QCommandLineOption repeatsOption ("repeats", "Number of timed runs of every stage.", "R", "5");
+    QCommandLineOption stagesOption ("stages", "Comma separated stages to time, all of them by default.", "stage,...");
+    QCommandLineOption outOption ("out", "JSON file of the results, the standard output by default.", "file");
+    parser.addOptions ({sizesOption, platesOption, seedOption, repeatsOption, stagesOption, outOption});
+    parser.process (a);
+
+    bool platesOk, seedOk, repeatsOk;
+    int plates = parser.value (platesOption).toInt (&platesOk);
+    quint64 seed = parser.value (seedOption).toULongLong (&seedOk);
+    int repeats = parser.value (repeatsOption).toInt (&repeatsOk);
+    std::vector<size_t> sizes;
+    bool sizesOk = true;
+    for (const QString &size : parser.value (sizesOption).split (','))
+    {
+        bool sizeOk;
+        sizes.push_back (size.toULongLong (&sizeOk));
+        sizesOk &= sizeOk && sizes.back () >= 10 && int(sizes.back ()) >= plates;
+    }
+    std::set<std::string> stages;
+    if (parser.isSet (stagesOption))
+    {
+        for (const QString &stage : parser.value (stagesOption).split (','))
+            stages.insert (stage.toStdString ());
+    }
+
+    if (!platesOk || !seedOk || !repeatsOk || !sizesOk || plates < 2 || repeats < 1)
+    {
+        std::cerr << "Invalid arguments" << std::endl;
+        parser.showHelp (1);
+    }
+
+    // The topology stages use a cache of their own, which neither reads nor fills the one of the generator.
+    const std::filesystem::path topologyCache = std::filesystem::temp_directory_path() / "planet_bench_topology";
+    TopologyCache::setDirectory (QString::fromStdString (topologyCache.string ()));
+
+    // The stages log their progress on the standard output, which is kept for the results.
+    std::ostringstream stageLog;
+    std::streambuf *standardOutput = std::cout.rdbuf (stageLog.rdbuf ());
+    std::vector<PlanetBench::Result> results;
+    for (size_t size : sizes)
+    {
+        PlanetBench bench (size, plates, seed, repeats, stages);
+        std::vector<PlanetBench::Result> sizeResults = bench.run ();
+        results.insert (results.end (), sizeResults.begin (), sizeResults.end ());
+        stageLog.str ("");
+    }
+    std::cout.rdbuf (standardOutput);
+    std::filesystem::remove_all (topologyCache);
+
+    if (parser.isSet (outOption))
+    {
+        std::ofstream out (parser.value (outOption).toStdString ());
+        writeJson (out, results, seed, repeats);
+        if (!out)
+        {
+            std::cerr << "Couldn't write " << parser.value (outOption).toStdString () << std::endl;
+            return 1;
+        }
+    }
+    else
+        writeJson (std::cout, results, seed, repeats);
+    return 0;
+}